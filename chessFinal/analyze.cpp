@@ -0,0 +1,192 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "smp.h"
+#include "tablebase.h"
+using namespace std;
+
+// ======================= Line Reader =======================
+// Reads a file a buffer at a time and hands out one line at a time as a
+// view into the buffer, so memory use does not grow with the input. A line
+// longer than the buffer is skipped and counted.
+const size_t ReadBufferSize = 1 << 16;
+
+class LineReader {
+public:
+    uint64_t overlong;
+
+    explicit LineReader(FILE* f) : overlong(0), file(f), begin(0), end(0), eof(false) {}
+
+    // The view stays valid until the next call.
+    bool next(string_view& line) {
+        bool discarding = false;
+        for (;;) {
+            char* nl = (char*)memchr(buf + begin, '\n', end - begin);
+            if (nl) {
+                size_t len = nl - (buf + begin);
+                size_t at = begin;
+                begin += len + 1;
+                if (discarding) { discarding = false; continue; }
+                if (len > 0 && buf[at + len - 1] == '\r') len--;
+                line = string_view(buf + at, len);
+                return true;
+            }
+            if (eof) {
+                if (begin == end || discarding) return false;
+                line = string_view(buf + begin, end - begin);
+                begin = end;
+                return true;
+            }
+            if (begin == 0 && end == ReadBufferSize) {
+                // No newline in a full buffer: drop the rest of this line
+                if (!discarding) overlong++;
+                discarding = true;
+                end = 0;
+            }
+            memmove(buf, buf + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            size_t n = fread(buf + end, 1, ReadBufferSize - end, file);
+            if (n == 0) eof = true;
+            end += n;
+        }
+    }
+
+private:
+    FILE* file;
+    char buf[ReadBufferSize];
+    size_t begin, end;
+    bool eof;
+};
+
+// ======================= EPD Analysis =======================
+// Each output line repeats the input position and operations, then adds
+// standard EPD opcodes: ce (score in centipawns for the side to move),
+// acd (depth), acn (nodes) and pm (predicted move, in coordinate notation).
+// Positions found in the tablebases get the exact result instead of a
+// search, with dm (mate in N moves) when the side to move wins.
+struct AnalyzeOptions {
+    bool search;
+    SearchLimits limits;
+    int threads;
+    size_t hashMb;
+    string tbDir;
+    AnalyzeOptions() : search(false), threads(1), hashMb(64) {}
+};
+
+// Split "<placement> <side> <castling> <ep> <operations...>". Plain FEN
+// lines work too: numeric move counters stay with the position.
+bool splitEpd(string_view line, string& fen, string_view& ops) {
+    size_t at = 0;
+    for (int field = 0;field < 6;field++) {
+        size_t next = line.find_first_not_of(" \t", at);
+        if (next == string_view::npos) {
+            if (field < 4) return false;
+            break;
+        }
+        if (field >= 4 && (line[next] < '0' || line[next] > '9')) break;
+        at = line.find_first_of(" \t", next);
+        if (at == string_view::npos) at = line.size();
+    }
+    fen.assign(line.data(), at);
+    size_t rest = line.find_first_not_of(" \t", at);
+    ops = rest == string_view::npos ? string_view() : line.substr(rest);
+    return true;
+}
+
+int analyze(FILE* in, FILE* out, const AnalyzeOptions& opt) {
+    TranspositionTable tt;
+    SmpSearch search;
+    PawnHashTable pawnTable;
+    Tablebases tablebases;
+    if (!opt.tbDir.empty() && tablebases.init(opt.tbDir) == 0) fprintf(stderr, "%s: no tablebase files\n", opt.tbDir.c_str());
+    uint64_t tbHits = 0;
+    if (opt.search) {
+        tt.resize(opt.hashMb);
+        search.setTable(&tt);
+        search.setThreads(opt.threads);
+    }
+
+    LineReader reader(in);
+    string_view line, ops;
+    string fen;
+    const vector<uint64_t> noHistory;
+    uint64_t done = 0, skipped = 0;
+    auto start = chrono::steady_clock::now();
+    while (reader.next(line)) {
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string_view::npos || line[first] == '#') continue;
+        Position pos;
+        if (!splitEpd(line, fen, ops) || !pos.setFen(fen)) {
+            skipped++;
+            continue;
+        }
+        fprintf(out, "%s", fen.c_str());
+        if (!ops.empty()) fprintf(out, " %.*s", (int)ops.size(), ops.data());
+        TbEntry tb;
+        Move tbMove = tablebases.tableCount() ? tablebases.bestMove(pos, &tb) : MOVE_NONE;
+        if (tbMove != MOVE_NONE) {
+            fprintf(out, " ce %d; acd 0; pm %s;", tbScore(tb), moveToUci(tbMove).c_str());
+            if (tb.wdl > 0) fprintf(out, " dm %d;", (tb.plies + 1) / 2);
+            fprintf(out, "\n");
+            tbHits++;
+        }
+        else if (opt.search) {
+            SearchInfo info = search.think(pos, noHistory, opt.limits);
+            fprintf(out, " ce %d; acd %d; acn %llu; pm %s;\n", info.score, info.depth,
+                (unsigned long long)info.nodes, info.bestMove() ? moveToUci(info.bestMove()).c_str() : "none");
+        }
+        else {
+            fprintf(out, " ce %d;\n", evaluate(pos, &pawnTable));
+        }
+        done++;
+    }
+    fflush(out);
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%llu positions in %.2f s (%.0f/s), %llu from tablebases, %llu invalid lines skipped, %llu overlong lines skipped\n",
+        (unsigned long long)done, secs, secs > 0 ? done / secs : 0.0, (unsigned long long)tbHits,
+        (unsigned long long)skipped, (unsigned long long)reader.overlong);
+    return 0;
+}
+
+void usage() {
+    fprintf(stderr, "Usage: analyze <file.epd|-> [--out file] [--depth D | --movetime ms] [--threads N] [--hash MB] [--tb DIR]\n"
+        "  Without --depth or --movetime each position gets a static evaluation.\n"
+        "  With --tb, positions of up to %d pieces are looked up in the tablebases first.\n", TB_MAX_PIECES);
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc < 2) { usage(); return 2; }
+    string inName = argv[1], outName;
+    AnalyzeOptions opt;
+    for (int i = 2;i < argc;i++) {
+        string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) outName = argv[++i];
+        else if (arg == "--depth" && i + 1 < argc) { opt.search = true; opt.limits.depth = atoi(argv[++i]); }
+        else if (arg == "--movetime" && i + 1 < argc) { opt.search = true; opt.limits.movetimeMs = atoll(argv[++i]); }
+        else if (arg == "--threads" && i + 1 < argc) opt.threads = atoi(argv[++i]);
+        else if (arg == "--hash" && i + 1 < argc) opt.hashMb = (size_t)atoi(argv[++i]);
+        else if (arg == "--tb" && i + 1 < argc) opt.tbDir = argv[++i];
+        else { usage(); return 2; }
+    }
+
+    FILE* in = inName == "-" ? stdin : fopen(inName.c_str(), "rb");
+    if (!in) { fprintf(stderr, "Cannot open %s\n", inName.c_str()); return 1; }
+    FILE* out = outName.empty() ? stdout : fopen(outName.c_str(), "w");
+    if (!out) { fprintf(stderr, "Cannot create %s\n", outName.c_str()); return 1; }
+    static char outBuffer[1 << 16];
+    setvbuf(out, outBuffer, _IOFBF, sizeof(outBuffer));
+
+    int rc = analyze(in, out, opt);
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    return rc;
+}
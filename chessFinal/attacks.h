@@ -0,0 +1,230 @@
+#pragma once
+#include "bitboard.h"
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// ======================= Reference Attack Sets =======================
+// Squares a piece on `sq` attacks, computed by walking the board. Sliders
+// stop at the first occupied square in each direction (that square is
+// included, friend or foe). Only used to build and verify the tables below.
+
+// Walk each (dr, dc) ray from sq until the edge or a blocker.
+inline Bitboard rayAttacks(int sq, Bitboard occupied, const int dirs[4][2]) {
+    Bitboard attacks = 0;
+    for (int d = 0;d < 4;d++) {
+        int r = rowOf(sq) + dirs[d][0], c = colOf(sq) + dirs[d][1];
+        while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+            Bitboard b = squareBB(makeSquare(r, c));
+            attacks |= b;
+            if (occupied & b) break;
+            r += dirs[d][0];c += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+constexpr int RookDirs[4][2] = { {-1,0},{1,0},{0,-1},{0,1} };
+constexpr int BishopDirs[4][2] = { {-1,-1},{-1,1},{1,-1},{1,1} };
+constexpr int KnightDeltas[8][2] = { {-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1} };
+constexpr int KingDeltas[8][2] = { {-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1} };
+
+constexpr Bitboard leaperAttacks(int sq, const int deltas[8][2]) {
+    Bitboard attacks = 0;
+    for (int d = 0;d < 8;d++) {
+        int r = rowOf(sq) + deltas[d][0], c = colOf(sq) + deltas[d][1];
+        if (r >= 0 && r < 8 && c >= 0 && c < 8) attacks |= squareBB(makeSquare(r, c));
+    }
+    return attacks;
+}
+
+// White pawns move towards row 0, black pawns towards row 7.
+constexpr Bitboard pawnAttacksSlow(Color c, int sq) {
+    Bitboard b = squareBB(sq);
+    if (c == WHITE) return ((b & ~FileABB) >> 9) | ((b & ~FileHBB) >> 7);
+    return ((b & ~FileABB) << 7) | ((b & ~FileHBB) << 9);
+}
+
+// ======================= Attack Tables =======================
+// Sliders use magic bitboards (or PEXT when built with USE_PEXT on a BMI2
+// CPU): the relevant blockers are hashed to an index into a shared table,
+// so every lookup is a mask, a multiply and a shift.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return (unsigned)_pext_u64(occupied, mask);
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// Pawn, knight and king attacks are fixed, so they are built by the compiler.
+struct LeaperTables {
+    Bitboard pawn[2][64];
+    Bitboard knight[64];
+    Bitboard king[64];
+};
+
+constexpr LeaperTables buildLeaperTables() {
+    LeaperTables t = {};
+    for (int sq = 0;sq < 64;sq++) {
+        t.pawn[WHITE][sq] = pawnAttacksSlow(WHITE, sq);
+        t.pawn[BLACK][sq] = pawnAttacksSlow(BLACK, sq);
+        t.knight[sq] = leaperAttacks(sq, KnightDeltas);
+        t.king[sq] = leaperAttacks(sq, KingDeltas);
+    }
+    return t;
+}
+
+inline constexpr LeaperTables Leapers = buildLeaperTables();
+
+inline Bitboard RookTable[0x19000];
+inline Bitboard BishopTable[0x1480];
+inline Magic RookMagics[64];
+inline Magic BishopMagics[64];
+inline Bitboard BetweenBB[64][64];   // squares strictly between two aligned squares
+inline Bitboard LineBB[64][64];      // whole line through two aligned squares
+
+constexpr Bitboard pawnAttacks(Color c, int sq) { return Leapers.pawn[c][sq]; }
+constexpr Bitboard knightAttacks(int sq) { return Leapers.knight[sq]; }
+constexpr Bitboard kingAttacks(int sq) { return Leapers.king[sq]; }
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = RookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = BishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+inline Bitboard attacksFrom(PieceType t, Color c, int sq, Bitboard occupied) {
+    switch (t) {
+    case PAWN: return pawnAttacks(c, sq);
+    case KNIGHT: return knightAttacks(sq);
+    case BISHOP: return bishopAttacks(sq, occupied);
+    case ROOK: return rookAttacks(sq, occupied);
+    case QUEEN: return queenAttacks(sq, occupied);
+    case KING: return kingAttacks(sq);
+    default: return 0;
+    }
+}
+
+// Magic multipliers for this square layout (a8 = 0), found offline with a
+// sparse-random search; verifyAttackTables() proves they are collision-free.
+const Bitboard RookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+const Bitboard BishopMagicNumbers[64] = {
+    0x1010900200902200ULL, 0x0260046086204080ULL, 0x0804087081012C80ULL, 0x0008208A240A1084ULL,
+    0x0004042080020020ULL, 0x8019100210008080ULL, 0x0400480444212004ULL, 0xA200240C02882800ULL,
+    0xA0A0042008410102ULL, 0x064A08010802004AULL, 0x0008080204322440ULL, 0x0031280600400200ULL,
+    0x0000240504100C00ULL, 0x1404020804040400ULL, 0x39A0042104022012ULL, 0x0000802092101005ULL,
+    0x0010602420021C44ULL, 0x2020000802841044ULL, 0x15C0800802031022ULL, 0x0084000804240800ULL,
+    0x0013002820080001ULL, 0x050102008080C008ULL, 0x8040882062082000ULL, 0x5001840044208810ULL,
+    0x0002400110108201ULL, 0x0110080022424421ULL, 0x0800A60410040844ULL, 0x1144040080410200ULL,
+    0x0106001002005001ULL, 0x1811050012048080ULL, 0x80020C0800410800ULL, 0x8001204011040880ULL,
+    0x048484404A200284ULL, 0x0000901004040480ULL, 0x5224004800210204ULL, 0x05A6008020020201ULL,
+    0x0010220200002008ULL, 0x0632080201404044ULL, 0x100801004C010818ULL, 0x0011012601A10444ULL,
+    0x0004112441071021ULL, 0x8812021004060314ULL, 0x0000082690000801ULL, 0xC000020212000400ULL,
+    0x0000084104002442ULL, 0x0081100101100200ULL, 0x7288816102018404ULL, 0x9408008C0048208AULL,
+    0x08040C0208440200ULL, 0x0000440088080400ULL, 0x00200D0290D00160ULL, 0x4000000020880008ULL,
+    0x000840A002048001ULL, 0x0001204410208400ULL, 0x4040880280861288ULL, 0x20103C0800604100ULL,
+    0x050841040101C000ULL, 0x2020102401241040ULL, 0x4A12000024020800ULL, 0x3201000C00420200ULL,
+    0xA559000004050408ULL, 0x1102440892080A10ULL, 0x0400402849046080ULL, 0x0060111001090121ULL
+};
+
+// Fill the lookup table for one slider type. Blockers on the board edge
+// never change the attack set, so they are left out of the mask.
+inline void initMagics(Bitboard table[], Magic magics[], const Bitboard magicNumbers[64], const int dirs[4][2]) {
+    Bitboard* next = table;
+    for (int sq = 0;sq < 64;sq++) {
+        Bitboard edges = ((Rank1BB | Rank8BB) & ~(Rank8BB << (8 * rowOf(sq))))
+            | ((FileABB | FileHBB) & ~(FileABB << colOf(sq)));
+        Magic& m = magics[sq];
+        m.mask = rayAttacks(sq, 0, dirs) & ~edges;
+        m.magic = magicNumbers[sq];
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = next;
+
+        // Carry-Rippler: enumerate every subset of the mask
+        Bitboard b = 0;
+        do {
+            m.attacks[m.index(b)] = rayAttacks(sq, b, dirs);
+            next++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+// Must run once before any attack lookup.
+inline void initAttacks() {
+    initMagics(RookTable, RookMagics, RookMagicNumbers, RookDirs);
+    initMagics(BishopTable, BishopMagics, BishopMagicNumbers, BishopDirs);
+
+    for (int a = 0;a < 64;a++) {
+        for (int b = 0;b < 64;b++) {
+            BetweenBB[a][b] = LineBB[a][b] = 0;
+            if (rookAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BetweenBB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            }
+            else if (bishopAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BetweenBB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+// Self-check: compare every table entry with the ray-walking reference.
+// Returns the number of mismatching entries (0 when the tables are sound).
+inline int verifyAttackTables() {
+    int errors = 0;
+    for (int sq = 0;sq < 64;sq++) {
+        for (int c = WHITE;c <= BLACK;c++) {
+            if (pawnAttacks(Color(c), sq) != pawnAttacksSlow(Color(c), sq)) errors++;
+        }
+        if (knightAttacks(sq) != leaperAttacks(sq, KnightDeltas)) errors++;
+        if (kingAttacks(sq) != leaperAttacks(sq, KingDeltas)) errors++;
+
+        const Magic* magics[2] = { &RookMagics[sq], &BishopMagics[sq] };
+        const int (*dirs[2])[2] = { RookDirs, BishopDirs };
+        for (int k = 0;k < 2;k++) {
+            Bitboard mask = magics[k]->mask, b = 0;
+            do {
+                Bitboard fromTable = (k == 0) ? rookAttacks(sq, b) : bishopAttacks(sq, b);
+                if (fromTable != rayAttacks(sq, b, dirs[k])) errors++;
+                b = (b - mask) & mask;
+            } while (b);
+        }
+    }
+    return errors;
+}
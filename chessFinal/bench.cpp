@@ -0,0 +1,457 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "evalbatch.h"
+#include "smp.h"
+using namespace std;
+
+// ======================= Bench Positions =======================
+// Fixed set so runs on different machines and builds compare directly.
+const char* BenchFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "2r3k1/pp3ppp/4p3/3nP3/3P4/P4N2/1P3PPP/2R3K1 w - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// ======================= Allocation Counting =======================
+// Every operator new in this program goes through here, so a bench can
+// read the count before and after a loop.
+atomic<uint64_t> heapAllocations(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ======================= SMP Time-to-Depth =======================
+// Searches every bench position to a fixed depth with 1, 2, 4 ... N
+// threads, clearing the table before each position, and reports the
+// wall time and speedup relative to one thread.
+int benchSmp(int maxThreads, int depth, size_t hashMb) {
+    TranspositionTable tt;
+    tt.resize(hashMb);
+    SmpSearch search;
+    search.setTable(&tt);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    vector<int> counts;
+    for (int t = 1;t < maxThreads;t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    double baseline = 0;
+    cout << "Time to depth " << depth << " over " << size(BenchFens) << " positions, " << hashMb << " MB hash\n";
+    for (int threads : counts) {
+        search.setThreads(threads);
+        uint64_t nodes = 0, pawnProbes = 0, pawnHits = 0;
+        double secs = 0;
+        for (const char* fen : BenchFens) {
+            Position pos;
+            pos.setFen(fen);
+            tt.clear();
+            auto start = chrono::steady_clock::now();
+            SearchInfo info = search.think(pos, vector<uint64_t>(), limits);
+            secs += secondsSince(start);
+            nodes += info.nodes;
+            pawnProbes += info.pawnProbes;
+            pawnHits += info.pawnHits;
+        }
+        if (threads == 1) baseline = secs;
+        cout << "threads " << threads << "  time " << secs << " s  nodes " << nodes
+            << "  nps " << (secs > 0 ? (uint64_t)(nodes / secs) : 0)
+            << "  speedup " << (secs > 0 ? baseline / secs : 0) << "x"
+            << "  pawn hash hits " << (pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0) << "%\n";
+    }
+    return 0;
+}
+
+// ======================= Evaluation =======================
+// Positions reached by random playouts from the bench set, with a fixed
+// seed so every run evaluates the same ones.
+vector<Position> samplePositions(int count) {
+    vector<Position> out;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() {
+        seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+        return seed * 2685821657736338717ULL;
+    };
+    while ((int)out.size() < count) {
+        for (const char* fen : BenchFens) {
+            Position pos;
+            pos.setFen(fen);
+            for (int ply = 0;ply < 40 && (int)out.size() < count;ply++) {
+                MoveList moves;
+                generateLegal(pos, moves);
+                if (moves.size() == 0) break;
+                pos.applyMove(moves[next() % moves.size()]);
+                out.push_back(pos);
+            }
+        }
+    }
+    return out;
+}
+
+// Colours swapped and the board flipped top to bottom; the side to move
+// swaps too, so its evaluation must come out identical.
+Position mirrorPosition(const Position& pos) {
+    Position m;
+    m.clear();
+    for (int p = 0;p < 12;p++) {
+        Piece flipped = makePiece(!colorOf(Piece(p)), typeOf(Piece(p)));
+        for (Bitboard b = pos.pieces(Piece(p));b;) m.putPiece(flipped, popLsb(b) ^ 56);
+    }
+    m.sideToMove = !pos.sideToMove;
+    m.castling = ((pos.castling & 3) << 2) | (pos.castling >> 2);
+    m.epSquare = pos.epSquare == NO_SQUARE ? NO_SQUARE : pos.epSquare ^ 56;
+    m.halfmoveClock = pos.halfmoveClock;
+    m.fullmoveNumber = pos.fullmoveNumber;
+    m.key = m.computeKey();
+    m.updateCheckInfo();
+    return m;
+}
+
+// Mirror symmetry over the sample set, then evaluations per second.
+int benchEval(int count) {
+    vector<Position> positions = samplePositions(count);
+    int asymmetric = 0;
+    for (const Position& pos : positions) {
+        Position m = mirrorPosition(pos);
+        if (evaluate(pos) != evaluate(m)) {
+            if (asymmetric++ < 5) cout << "Asymmetric: " << evaluate(pos) << " vs " << evaluate(m) << " after mirroring\n";
+        }
+        if (pos.psq != pos.computePsq()) {
+            if (asymmetric++ < 5) cout << "Incremental PSQ score out of date\n";
+        }
+    }
+    cout << "Symmetry: " << positions.size() << " positions, "
+        << (asymmetric ? to_string(asymmetric) + " failures" : string("OK")) << "\n";
+
+    const int passes = 50;
+    int64_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0;i < passes;i++)
+        for (const Position& pos : positions) sink += evaluate(pos);
+    double secs = secondsSince(start);
+    uint64_t evals = (uint64_t)passes * positions.size();
+    cout << "evaluate:    " << evals << " evals  " << secs << " s  "
+        << (secs > 0 ? (uint64_t)(evals / secs) : 0) << " evals/s  (pawns recomputed)\n";
+
+    // Same positions through the pawn hash table, a playout at a time as a
+    // search would visit them
+    PawnHashTable pawnTable;
+    start = chrono::steady_clock::now();
+    for (int i = 0;i < passes;i++)
+        for (const Position& pos : positions) sink += evaluate(pos, &pawnTable);
+    secs = secondsSince(start);
+    cout << "evaluate:    " << evals << " evals  " << secs << " s  "
+        << (secs > 0 ? (uint64_t)(evals / secs) : 0) << " evals/s  (pawn hash, "
+        << pawnTable.hitRate() << "% hits)\n";
+
+    // What the incremental material + PST sum saves per evaluation
+    start = chrono::steady_clock::now();
+    for (int i = 0;i < passes;i++)
+        for (const Position& pos : positions) sink += mgValue(pos.computePsq());
+    secs = secondsSince(start);
+    cout << "psq rescan:  " << evals << " sums   " << secs << " s  "
+        << (secs > 0 ? (uint64_t)(evals / secs) : 0) << " sums/s\n";
+    cout << "checksum " << sink << "\n";   // keeps the loops from being optimised away
+    return asymmetric ? 1 : 0;
+}
+
+// ======================= Batch Evaluation =======================
+// The sample set through evaluateBatch() with each kernel. Every kernel
+// must reproduce evaluate() exactly; positions/s compares the two.
+int benchBatch(int count) {
+    vector<Position> positions = samplePositions(count);
+    // Promotions can give one side more pieces than the AVX2 kernel has
+    // slots for; those positions must still match evaluate()
+    for (const char* fen : { "7k/8/8/8/NNNNNNNN/NNNNNNNN/N7/K7 w - - 0 1", "k7/n7/nnnnnnnn/nnnnnnnn/8/8/8/7K b - - 0 1",
+                             "k7/qqqqqqqq/qqqqqqqq/1q6/8/8/QQQQQQQQ/QQQQQQQK w - - 0 1" }) {
+        Position pos;
+        if (!pos.setFen(fen)) { cout << "Bad FEN " << fen << "\n"; return 1; }
+        positions.push_back(pos);
+    }
+    vector<int> expected(positions.size()), got(positions.size());
+    for (size_t i = 0;i < positions.size();i++) expected[i] = evaluate(positions[i]);
+
+    cout << "CPU AVX2: " << (cpuHasAvx2() ? "yes" : "no") << ", runtime kernel "
+        << evalKernelName(bestEvalKernel()) << "\n";
+    const int passes = 50;
+    uint64_t evals = (uint64_t)passes * positions.size();
+    double scalarSecs = 0;
+    int failures = 0;
+    for (EvalKernel k : { KERNEL_SCALAR, KERNEL_AVX2 }) {
+        if (k == KERNEL_AVX2 && !cpuHasAvx2()) { cout << "avx2:    skipped, not supported on this CPU\n"; continue; }
+        evaluateBatch(positions.data(), positions.size(), got.data(), nullptr, k);
+        int wrong = 0;
+        for (size_t i = 0;i < positions.size();i++) wrong += got[i] != expected[i];
+        failures += wrong;
+
+        int64_t sink = 0;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0;i < passes;i++) {
+            evaluateBatch(positions.data(), positions.size(), got.data(), nullptr, k);
+            sink += got[i % got.size()];
+        }
+        double secs = secondsSince(start);
+        if (k == KERNEL_SCALAR) scalarSecs = secs;
+        cout << evalKernelName(k) << (k == KERNEL_AVX2 ? ":    " : ":  ") << evals << " positions  " << secs << " s  "
+            << (secs > 0 ? (uint64_t)(evals / secs) : 0) << " positions/s";
+        if (k != KERNEL_SCALAR && secs > 0) cout << "  (" << scalarSecs / secs << "x scalar)";
+        cout << "  " << (wrong ? to_string(wrong) + " mismatches" : string("matches evaluate()"))
+            << "  checksum " << sink << "\n";
+    }
+    return failures ? 1 : 0;
+}
+
+// ======================= Heap Allocations per Move =======================
+// Steady-state move handling must not touch the heap: random playouts
+// that generate, make and unmake every legal move, then a self-play game
+// searched move by move. Exits non-zero if either allocates.
+int benchAlloc(int threads, int depth) {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() {
+        seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+        return seed * 2685821657736338717ULL;
+    };
+
+    const int games = 2000;
+    uint64_t moves = 0, before = heapAllocations;
+    auto start = chrono::steady_clock::now();
+    for (int g = 0;g < games;g++) {
+        Position pos;
+        pos.setStartPosition();
+        for (int ply = 0;ply < 200;ply++) {
+            MoveList list;
+            generateLegal(pos, list);
+            if (list.size() == 0 || pos.halfmoveClock >= 100) break;
+            for (int i = 0;i < list.count;i++) {
+                UndoInfo undo;
+                pos.makeMove(list[i], undo);
+                pos.unmakeMove(list[i], undo);
+            }
+            pos.applyMove(list[next() % list.size()]);
+            moves += list.size() + 1;
+        }
+    }
+    double secs = secondsSince(start);
+    uint64_t playoutAllocs = heapAllocations - before;
+    cout << "playouts:  " << moves << " moves made  " << secs << " s  "
+        << playoutAllocs << " heap allocations\n";
+
+    // Self-play: the table, searchers and game history are set up first;
+    // the first moves warm up anything that grows on demand
+    TranspositionTable tt;
+    tt.resize(16);
+    SmpSearch search;
+    search.setTable(&tt);
+    search.setThreads(threads);
+    SearchLimits limits;
+    limits.depth = depth;
+    vector<uint64_t> keys;
+    keys.reserve(1024);
+    Position pos;
+    pos.setStartPosition();
+    keys.push_back(pos.key);
+
+    const int warmup = 4, plies = 80;
+    uint64_t searchAllocs = 0, searched = 0, nodes = 0;
+    for (int ply = 0;ply < plies;ply++) {
+        MoveList list;
+        generateLegal(pos, list);
+        if (list.size() == 0 || pos.halfmoveClock >= 100) break;
+        before = heapAllocations;
+        SearchInfo info = search.think(pos, keys, limits);
+        pos.applyMove(info.bestMove());
+        keys.push_back(pos.key);
+        if (ply >= warmup) {
+            searchAllocs += heapAllocations - before;
+            searched++;
+            nodes += info.nodes;
+        }
+    }
+    cout << "self-play: " << searched << " moves at depth " << depth << " on " << threads << " thread(s), "
+        << nodes << " nodes  " << searchAllocs << " heap allocations ("
+        << (searched ? double(searchAllocs) / searched : 0.0) << " per move)\n";
+    return playoutAllocs || searchAllocs ? 1 : 0;
+}
+
+// ======================= Copy-Make vs Make/Unmake =======================
+// Perft over the bench positions both ways: one Position updated and
+// restored in place, or a fresh 112-byte copy per child.
+uint64_t perftUnmake(Position& pos, int depth) {
+    MoveList list;
+    generateLegal(pos, list);
+    if (depth == 1) return list.size();
+    uint64_t n = 0;
+    for (int i = 0;i < list.count;i++) {
+        UndoInfo undo;
+        pos.makeMove(list[i], undo);
+        n += perftUnmake(pos, depth - 1);
+        pos.unmakeMove(list[i], undo);
+    }
+    return n;
+}
+
+uint64_t perftCopy(const Position& pos, int depth) {
+    MoveList list;
+    generateLegal(pos, list);
+    if (depth == 1) return list.size();
+    uint64_t n = 0;
+    for (int i = 0;i < list.count;i++) n += perftCopy(pos.after(list[i]), depth - 1);
+    return n;
+}
+
+int benchCopyMake(int depth) {
+    cout << "Perft " << depth << " over " << size(BenchFens) << " positions, Position is " << sizeof(Position) << " bytes\n";
+    uint64_t nodes[2] = { 0, 0 };
+    double secs[2] = { 0, 0 };
+    for (const char* fen : BenchFens) {
+        Position pos;
+        pos.setFen(fen);
+        auto start = chrono::steady_clock::now();
+        nodes[0] += perftUnmake(pos, depth);
+        secs[0] += secondsSince(start);
+        start = chrono::steady_clock::now();
+        nodes[1] += perftCopy(pos, depth);
+        secs[1] += secondsSince(start);
+    }
+    const char* names[2] = { "make/unmake", "copy-make  " };
+    for (int i = 0;i < 2;i++) {
+        cout << names[i] << "  nodes " << nodes[i] << "  time " << secs[i] << " s  nps "
+            << (secs[i] > 0 ? (uint64_t)(nodes[i] / secs[i]) : 0) << "\n";
+    }
+    if (nodes[0] != nodes[1]) { cout << "Node counts differ!\n"; return 1; }
+    cout << "copy-make / make-unmake time: " << (secs[0] > 0 ? secs[1] / secs[0] : 0) << "\n";
+    return 0;
+}
+
+// ======================= Game Status =======================
+// The check, checkmate and stalemate tests the game runs every turn.
+// "recomputed" is what they cost when nothing is kept between moves:
+// checkers and pins found from the king square, then the full legal move
+// list. "incremental" reads the checkers makeMove() stored and stops at
+// the first legal king move. Both must agree on every position.
+enum GameStatus { STATUS_PLAYING, STATUS_CHECK, STATUS_CHECKMATE, STATUS_STALEMATE };
+
+GameStatus statusRecomputed(const Position& pos) {
+    Position p = pos;
+    p.updateCheckInfo();
+    int k = p.kingSquare(p.sideToMove);
+    bool check = k != NO_SQUARE && p.isAttacked(k, !p.sideToMove);
+    MoveList list;
+    generateLegal(p, list);
+    if (list.size() == 0) return check ? STATUS_CHECKMATE : STATUS_STALEMATE;
+    return check ? STATUS_CHECK : STATUS_PLAYING;
+}
+
+GameStatus statusIncremental(const Position& pos) {
+    bool check = pos.inCheck(pos.sideToMove);
+    if (!hasLegalMoves(pos)) return check ? STATUS_CHECKMATE : STATUS_STALEMATE;
+    return check ? STATUS_CHECK : STATUS_PLAYING;
+}
+
+int benchStatus(int count) {
+    vector<Position> positions = samplePositions(count);
+    // A few finished games, so mate and stalemate are timed too
+    const char* finished[] = {
+        "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+        "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",
+        "k7/8/1QK5/8/8/8/8/8 b - - 0 1",
+        "6rk/5Npp/8/8/8/8/8/6K1 b - - 0 1",
+    };
+    for (const char* fen : finished) {
+        Position pos;
+        pos.setFen(fen);
+        positions.push_back(pos);
+    }
+
+    int tally[4] = { 0, 0, 0, 0 }, wrong = 0;
+    for (const Position& pos : positions) {
+        GameStatus s = statusRecomputed(pos);
+        tally[s]++;
+        if (statusIncremental(pos) != s) wrong++;
+    }
+    cout << positions.size() << " positions: " << tally[STATUS_CHECK] << " in check, " << tally[STATUS_CHECKMATE]
+        << " checkmate, " << tally[STATUS_STALEMATE] << " stalemate\n";
+
+    const int rounds = 50;
+    uint64_t sink = 0;
+    double secs[2];
+    const char* names[2] = { "recomputed ", "incremental" };
+    for (int i = 0;i < 2;i++) {
+        auto start = chrono::steady_clock::now();
+        for (int r = 0;r < rounds;r++) {
+            for (const Position& pos : positions) sink += i == 0 ? statusRecomputed(pos) : statusIncremental(pos);
+        }
+        secs[i] = secondsSince(start);
+        double turns = double(rounds) * positions.size();
+        cout << names[i] << "  " << (secs[i] * 1e9 / turns) << " ns per turn";
+        if (i == 1 && secs[i] > 0) cout << "  (" << secs[0] / secs[i] << "x)";
+        cout << "\n";
+    }
+    cout << (wrong ? to_string(wrong) + " positions disagree" : string("both agree on every position"))
+        << "  checksum " << sink << "\n";
+    return wrong ? 1 : 0;
+}
+
+void usage() {
+    cout << "Every mode takes --stats FILE: hot-path counters as JSON, or CSV for *.csv (CHESS_STATS builds)\n"
+        << "Usage: bench smp [--threads N] [--depth D] [--hash MB]\n"
+        << "       bench eval [--positions N]      exits non-zero if mirrored positions score differently\n"
+        << "       bench batch [--positions N]     batch evaluation, scalar vs AVX2 kernel\n"
+        << "       bench alloc [--threads N] [--depth D]   exits non-zero if a move allocates\n"
+        << "       bench copymake [--depth D]      perft with make/unmake against copy-make\n"
+        << "       bench status [--positions N]    per-turn check/mate/stalemate tests, recomputed vs incremental\n";
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc < 2) { usage(); return 2; }
+    string mode = argv[1];
+
+    int threads = (int)thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    int depth = 0;      // per-mode default
+    size_t hashMb = 64;
+    int positions = 20000;
+    string statsPath;
+    for (int i = 2;i < argc;i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg == "--depth" && i + 1 < argc) depth = atoi(argv[++i]);
+        else if (arg == "--hash" && i + 1 < argc) hashMb = (size_t)atoi(argv[++i]);
+        else if (arg == "--positions" && i + 1 < argc) positions = atoi(argv[++i]);
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else { usage(); return 2; }
+    }
+
+    int rc;
+    if (mode == "smp") rc = benchSmp(threads, depth ? depth : 9, hashMb);
+    else if (mode == "alloc") rc = benchAlloc(threads, depth ? depth : 5);
+    else if (mode == "copymake") rc = benchCopyMake(depth ? depth : 4);
+    else if (mode == "eval") rc = benchEval(positions);
+    else if (mode == "batch") rc = benchBatch(positions);
+    else if (mode == "status") rc = benchStatus(positions);
+    else { usage(); return 2; }
+    if (!statsPath.empty() && !writeStatsFile(statsPath)) { cout << "Cannot write " << statsPath << "\n"; return 1; }
+    return rc;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// ======================= Basic Types =======================
+// Squares follow the board's row/column layout: row 0 is rank 8 and
+// column 0 is file a, so square = row * 8 + col (a8 = 0, h1 = 63).
+typedef uint64_t Bitboard;
+
+enum Color : uint8_t { WHITE, BLACK };
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE_TYPE };
+enum Piece {
+    W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+    B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+    NO_PIECE
+};
+
+const int NO_SQUARE = -1;
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileHBB = FileABB << 7;
+constexpr Bitboard Rank8BB = 0xFFULL;
+constexpr Bitboard Rank1BB = Rank8BB << 56;
+
+constexpr Color operator!(Color c) { return Color(c ^ 1); }
+
+constexpr int makeSquare(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int sq) { return sq >> 3; }
+constexpr int colOf(int sq) { return sq & 7; }
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+
+// Algebraic names: "a8" is square 0, "h1" is square 63.
+inline std::string squareName(int sq) {
+    return std::string(1, char('a' + colOf(sq))) + char('0' + 8 - rowOf(sq));
+}
+
+inline int squareFromName(const std::string& s) {
+    if (s.size() != 2 || s[0] < 'a' || s[0] > 'h' || s[1] < '1' || s[1] > '8') return NO_SQUARE;
+    return makeSquare(8 - (s[1] - '0'), s[0] - 'a');
+}
+
+inline Piece makePiece(Color c, PieceType t) { return Piece(c * 6 + t); }
+inline Color colorOf(Piece p) { return Color(p >= B_PAWN); }
+inline PieceType typeOf(Piece p) { return PieceType(p % 6); }
+
+// Same letters the board has always printed: uppercase is White.
+inline char pieceSymbol(Piece p) { return "PNBRQKpnbrqk."[p]; }
+
+inline Piece pieceFromSymbol(char ch) {
+    switch (ch) {
+    case 'P': return W_PAWN;   case 'p': return B_PAWN;
+    case 'N': return W_KNIGHT; case 'n': return B_KNIGHT;
+    case 'B': return W_BISHOP; case 'b': return B_BISHOP;
+    case 'R': return W_ROOK;   case 'r': return B_ROOK;
+    case 'Q': return W_QUEEN;  case 'q': return B_QUEEN;
+    case 'K': return W_KING;   case 'k': return B_KING;
+    }
+    return NO_PIECE;
+}
+
+// ======================= Bit Tricks =======================
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(b);
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit; b must be non-zero.
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return (int)idx;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+
+// ======================= Moves =======================
+// 16-bit move: bits 0-5 from, 6-11 to, 12-15 flags.
+typedef uint16_t Move;
+
+enum MoveFlag {
+    QUIET = 0, DOUBLE_PUSH = 1, KING_CASTLE = 2, QUEEN_CASTLE = 3,
+    CAPTURE = 4, EP_CAPTURE = 5,
+    PROMOTION = 8,          // + 0..3 for knight, bishop, rook, queen
+    PROMOTION_CAPTURE = 12  // same, capturing
+};
+
+const Move MOVE_NONE = 0;
+
+inline Move encodeMove(int from, int to, int flag) { return Move(from | (to << 6) | (flag << 12)); }
+inline int moveFrom(Move m) { return m & 63; }
+inline int moveTo(Move m) { return (m >> 6) & 63; }
+inline int moveFlag(Move m) { return m >> 12; }
+inline bool isCapture(Move m) { return (moveFlag(m) & CAPTURE) != 0; }
+inline bool isPromotion(Move m) { return (moveFlag(m) & PROMOTION) != 0; }
+inline bool isCastle(Move m) { return moveFlag(m) == KING_CASTLE || moveFlag(m) == QUEEN_CASTLE; }
+inline PieceType promotionType(Move m) { return PieceType(KNIGHT + (moveFlag(m) & 3)); }
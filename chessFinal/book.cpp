@@ -0,0 +1,164 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include "book.h"
+#include "pgn.h"
+using namespace std;
+
+// ======================= Inputs =======================
+// PGN databases, game archives from gamedb, or plain move lists: one game
+// per line, moves in coordinate (e2e4) or SAN form, optionally ending in
+// a result. Lines starting with '#' are comments.
+bool addPgn(OpeningBookBuilder& builder, string_view text) {
+    PgnReader reader(text);
+    reader.onError = [](const PgnError& e) { cerr << "offset " << e.offset << ": " << e.message << "\n"; };
+    PgnGame game;
+    while (reader.next(game)) builder.addGame(game.start, game.moves, resultFromString(game.result));
+    return true;
+}
+
+bool addArchive(OpeningBookBuilder& builder, const string& path) {
+    GameArchive archive;
+    if (!archive.open(path)) return false;
+    GameView g;
+    Position start;
+    for (uint64_t n = 0;n < archive.size();n++) {
+        if (!archive.game(n, g)) continue;
+        if (!g.startPosition(start)) cerr << path << ": game " << n << ": corrupt start position, game ignored\n";
+        else if (!builder.addGame(start, vector<Move>(g.moves, g.moves + g.plies), g.result)) {
+            cerr << path << ": game " << n << ": illegal move, rest of game ignored\n";
+        }
+    }
+    return true;
+}
+
+bool addMoveLists(OpeningBookBuilder& builder, string_view text, const string& path) {
+    Position initial;
+    initial.setStartPosition();
+    vector<Move> moves;
+    int lineNo = 0;
+    for (size_t at = 0;at < text.size();) {
+        size_t end = text.find('\n', at);
+        if (end == string_view::npos) end = text.size();
+        string_view line = text.substr(at, end - at);
+        at = end + 1;
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+
+        Position pos = initial;
+        GameResult result = RESULT_NONE;
+        moves.clear();
+        for (size_t i = 0;i < line.size();) {
+            while (i < line.size() && isspace((unsigned char)line[i])) i++;
+            size_t j = i;
+            while (j < line.size() && !isspace((unsigned char)line[j])) j++;
+            if (j == i) break;
+            string_view token = line.substr(i, j - i);
+            i = j;
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") { result = resultFromString(token); break; }
+            Move m = parseSan(pos, token);
+            if (m == MOVE_NONE) {
+                cerr << path << ":" << lineNo << ": illegal move " << token << ", rest of line ignored\n";
+                break;
+            }
+            moves.push_back(m);
+            pos.applyMove(m);
+        }
+        if (!moves.empty()) builder.addGame(initial, moves, result);
+    }
+    return true;
+}
+
+// ======================= Commands =======================
+int build(const string& out, const vector<string>& inputs, int plies, uint32_t minGames) {
+    OpeningBookBuilder builder(plies);
+    auto start = chrono::steady_clock::now();
+    for (const string& path : inputs) {
+        if (addArchive(builder, path)) continue;
+        MappedFile file;
+        if (!file.open(path, true)) { cerr << "Cannot open " << path << "\n"; return 1; }
+        string_view text = file.view();
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first != string_view::npos && text[first] == '[') addPgn(builder, text);
+        else addMoveLists(builder, text, path);
+    }
+    int64_t entries = builder.write(out, minGames);
+    if (entries < 0) { cerr << "Error writing " << out << "\n"; return 1; }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << builder.games() << " games, " << entries << " book entries written in " << secs << " s\n";
+    return 0;
+}
+
+// Book moves for a position with their share of the weight, then the
+// cost of a lookup.
+int probe(const string& path, const string& fen) {
+    OpeningBook book;
+    if (!book.open(path)) { cerr << path << ": not an opening book\n"; return 1; }
+    Position pos;
+    if (fen.empty()) pos.setStartPosition();
+    else if (!pos.setFen(fen)) { cerr << "Invalid FEN\n"; return 1; }
+
+    // Entries whose move is not legal here (a key collision or a damaged
+    // book) are left out.
+    auto run = book.find(pos.key);
+    vector<const BookEntry*> legal;
+    uint64_t total = 0;
+    for (const BookEntry* e = run.first;e < run.second;e++) {
+        if (!isLegalMove(pos, e->move)) continue;
+        legal.push_back(e);
+        total += e->weight;
+    }
+    cout << book.size() << " entries, " << legal.size() << " for this position\n";
+    for (const BookEntry* e : legal) {
+        cout << moveToSan(pos, e->move) << "  weight " << e->weight << " (" << (100.0 * e->weight / total)
+            << "%)  games " << e->games << "\n";
+    }
+
+    const int lookups = 1000000;
+    uint64_t seed = 0x2545F4914F6CDD1DULL, sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0;i < lookups;i++) {
+        seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+        auto r = book.find(i & 1 ? pos.key : seed * 2685821657736338717ULL);
+        sink += r.second - r.first;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "lookup: " << (secs * 1e9 / lookups) << " ns  (checksum " << sink << ")\n";
+    return 0;
+}
+
+void usage() {
+    cerr << "Usage: book build <out.bin> <inputs...> [--plies N] [--min-games K]\n"
+        << "           inputs: PGN files, gamedb archives or move lists (one game per line)\n"
+        << "       book probe <book.bin> [FEN]          book moves for a position (default: initial)\n";
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc < 3) { usage(); return 2; }
+    string mode = argv[1];
+    if (mode == "build" && argc >= 4) {
+        int plies = 20;
+        uint32_t minGames = 1;
+        vector<string> inputs;
+        for (int i = 3;i < argc;i++) {
+            string arg = argv[i];
+            if (arg == "--plies" && i + 1 < argc) plies = atoi(argv[++i]);
+            else if (arg == "--min-games" && i + 1 < argc) minGames = (uint32_t)atoi(argv[++i]);
+            else inputs.push_back(arg);
+        }
+        if (inputs.empty()) { usage(); return 2; }
+        return build(argv[2], inputs, plies, minGames);
+    }
+    if (mode == "probe") {
+        string fen;
+        for (int i = 3;i < argc;i++) fen += string(i > 3 ? " " : "") + argv[i];
+        return probe(argv[2], fen);
+    }
+    usage();
+    return 2;
+}
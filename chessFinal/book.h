@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "gamefile.h"
+#include "movegen.h"
+
+// ======================= Opening Book =======================
+// Binary book, in host byte order (little-endian on every target):
+//   header   magic "CHSBOOK1", version, entry count (a GameArchiveHeader)
+//   entries  16 bytes each, sorted by key, best weight first within a key
+// The layout follows Polyglot's (key, move, weight, learn) but the key is
+// this engine's Zobrist key and the move its own 16-bit encoding, so a
+// lookup needs no conversion: binary search the mapped entries for
+// pos.key and pick one of the run by weight.
+const char OpeningBookMagic[8] = { 'C', 'H', 'S', 'B', 'O', 'O', 'K', '1' };
+
+struct BookEntry {
+    uint64_t key;
+    Move move;
+    uint16_t weight;            // relative choice weight, 1..65535
+    uint32_t games;             // games the move was played in
+};
+
+static_assert(sizeof(BookEntry) == 16, "BookEntry must stay 16 bytes");
+
+// Collects (position, move) pairs from games and writes the sorted book.
+// A move scores 2 for each game its side went on to win, 1 for a draw or
+// unknown result and 0 for a loss, so moves that only ever lost drop out.
+class OpeningBookBuilder {
+public:
+    explicit OpeningBookBuilder(int maxPlies = 20) : maxPlies(maxPlies), gamesAdded(0), nextCompact(CompactAt) {}
+
+    // Moves come from files, so each is checked before it is applied; false
+    // if one is not legal, with the game kept up to that move.
+    bool addGame(const Position& start, const std::vector<Move>& moves, GameResult result) {
+        Position pos = start;
+        bool legal = true;
+        for (size_t i = 0;i < moves.size() && (int)i < maxPlies;i++) {
+            if (!isLegalMove(pos, moves[i])) { legal = false; break; }
+            Color us = pos.sideToMove;
+            uint32_t points = result == DRAWN || result == RESULT_NONE ? 1
+                            : (result == WHITE_WINS) == (us == WHITE) ? 2 : 0;
+            pending.push_back({ pos.key, moves[i], points });
+            pos.applyMove(moves[i]);
+        }
+        gamesAdded++;
+        // Fold duplicates before the buffer outgrows the book it describes
+        if (pending.size() >= nextCompact) {
+            compact();
+            nextCompact = std::max(CompactAt, 2 * pending.size());
+        }
+        return legal;
+    }
+
+    uint64_t games() const { return gamesAdded; }
+
+    // Keeps moves seen in at least minGames games; returns the entry count
+    // written, or -1 on a write error.
+    int64_t write(const std::string& path, uint32_t minGames = 1) {
+        compact();
+        std::vector<BookEntry> entries;
+        for (const Pending& p : pending) {
+            if (p.games < minGames || p.points == 0) continue;
+            entries.push_back({ p.key, p.move, uint16_t(p.points < 0xFFFF ? p.points : 0xFFFF), p.games });
+        }
+        std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+            return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+        });
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return -1;
+        GameArchiveHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, OpeningBookMagic, sizeof(h.magic));
+        h.version = GameArchiveVersion;
+        h.gameCount = entries.size();
+        fwrite(&h, 1, sizeof(h), file);
+        if (!entries.empty()) fwrite(entries.data(), sizeof(BookEntry), entries.size(), file);
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        return ok ? (int64_t)entries.size() : -1;
+    }
+
+private:
+    struct Pending {
+        uint64_t key;
+        Move move;
+        uint32_t points;
+        uint32_t games = 1;
+    };
+    static constexpr size_t CompactAt = 1 << 22;    // about 100 MB of pending pairs
+
+    int maxPlies;
+    uint64_t gamesAdded;
+    std::vector<Pending> pending;
+    size_t nextCompact;
+
+    // Sort by (key, move) and merge equal pairs.
+    void compact() {
+        std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+            return a.key != b.key ? a.key < b.key : a.move < b.move;
+        });
+        size_t out = 0;
+        for (size_t i = 0;i < pending.size();i++) {
+            if (out > 0 && pending[out - 1].key == pending[i].key && pending[out - 1].move == pending[i].move) {
+                pending[out - 1].points += pending[i].points;
+                pending[out - 1].games += pending[i].games;
+            }
+            else pending[out++] = pending[i];
+        }
+        pending.resize(out);
+    }
+};
+
+class OpeningBook {
+public:
+    OpeningBook() : entries(nullptr), count(0) {}
+
+    bool open(const std::string& path) {
+        count = 0;
+        entries = nullptr;
+        if (!file.open(path)) return false;
+        GameArchiveHeader h;
+        if (file.size() < sizeof(h)) return false;
+        memcpy(&h, file.data(), sizeof(h));
+        if (memcmp(h.magic, OpeningBookMagic, sizeof(h.magic)) != 0 || h.version != GameArchiveVersion) return false;
+        if ((file.size() - sizeof(h)) / sizeof(BookEntry) < h.gameCount) return false;
+        entries = (const BookEntry*)(file.data() + sizeof(h));
+        count = h.gameCount;
+        return true;
+    }
+
+    bool isOpen() const { return count > 0; }
+    uint64_t size() const { return count; }
+
+    // The run of entries for this position, best weight first; empty
+    // (first == last) when it is not in the book.
+    std::pair<const BookEntry*, const BookEntry*> find(uint64_t key) const {
+        const BookEntry* first = std::lower_bound(entries, entries + count, key,
+            [](const BookEntry& e, uint64_t k) { return e.key < k; });
+        const BookEntry* last = first;
+        while (last < entries + count && last->key == key) last++;
+        return { first, last };
+    }
+
+    // A book move chosen with probability proportional to its weight, using
+    // random (any uniformly distributed value) as the dice. MOVE_NONE when
+    // the position is not in the book. Moves are checked for legality, so a
+    // key collision can never play an illegal move.
+    Move probe(const Position& pos, uint64_t random) const {
+        auto run = find(pos.key);
+        uint64_t total = 0;
+        for (const BookEntry* e = run.first;e < run.second;e++) total += e->weight;
+        if (total == 0) return MOVE_NONE;
+        uint64_t pick = random % total;
+        for (const BookEntry* e = run.first;e < run.second;e++) {
+            if (pick < e->weight) return isLegalMove(pos, e->move) ? e->move : MOVE_NONE;
+            pick -= e->weight;
+        }
+        return MOVE_NONE;
+    }
+
+private:
+    MappedFile file;
+    const BookEntry* entries;
+    uint64_t count;
+};
@@ -4,185 +4,61 @@
 #include <vector>
 #include <fstream>
 #include <cctype>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
 #include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "book.h"
+#include "movegen.h"
+#include "smp.h"
+#include "pgn.h"
+#include "savefile.h"
+#include "tablebase.h"
+#include "uci.h"
+#ifndef _WIN32
+#include "server.h"
+#endif
 using namespace std;
 
-// ======================= Piece Base Class =======================
-class Piece {
-protected:
-    char symbol;
-    bool isWhite;
-    bool hasMoved;
-public:
-    Piece(char s, bool white) : symbol(s), isWhite(white), hasMoved(false) {}
-    virtual ~Piece() {}
-    char getSymbol() const { return symbol; }
-    bool getColor() const { return isWhite; }
-    bool getHasMoved() const { return hasMoved; }
-    void setMoved() { hasMoved = true; }
-    void setHasMoved(bool v) { hasMoved = v; }
-    virtual bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) = 0;
-};
-
-// ======================= Pawn =======================
-class Pawn : public Piece {
-public:
-    Pawn(bool white) : Piece(white ? 'P' : 'p', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        int dir = isWhite ? -1 : 1;
-        // forward move
-        if (sc == ec && board[er][ec] == nullptr) {
-            if (er == sr + dir) return true;
-            if ((isWhite && sr == 6) || (!isWhite && sr == 1)) {
-                if (er == sr + 2 * dir && board[sr + dir][sc] == nullptr) return true;
-            }
-        }
-        // diagonal capture
-        if (abs(ec - sc) == 1 && er == sr + dir && board[er][ec] != nullptr) {
-            return board[er][ec]->getColor() != isWhite;
-        }
-        return false;
-    }
-};
-
-// ======================= Rook =======================
-class Rook : public Piece {
-public:
-    Rook(bool white) : Piece(white ? 'R' : 'r', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        if (sr != er && sc != ec) return false;
-        int dr = (er > sr) ? 1 : (er < sr ? -1 : 0);
-        int dc = (ec > sc) ? 1 : (ec < sc ? -1 : 0);
-        int r = sr + dr, c = sc + dc;
-        while (r != er || c != ec) {
-            if (board[r][c] != nullptr) return false;
-            r += dr;c += dc;
-        }
-        return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-    }
-};
-
-// ======================= Knight =======================
-class Knight : public Piece {
-public:
-    Knight(bool white) : Piece(white ? 'N' : 'n', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        int dr = abs(er - sr), dc = abs(ec - sc);
-        if ((dr == 2 && dc == 1) || (dr == 1 && dc == 2)) {
-            return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-        }
-        return false;
-    }
-};
-
-// ======================= Bishop =======================
-class Bishop : public Piece {
-public:
-    Bishop(bool white) : Piece(white ? 'B' : 'b', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        if (abs(er - sr) != abs(ec - sc)) return false;
-        int dr = (er > sr) ? 1 : -1, dc = (ec > sc) ? 1 : -1;
-        int r = sr + dr, c = sc + dc;
-        while (r != er && c != ec) {
-            if (board[r][c] != nullptr) return false;
-            r += dr;c += dc;
-        }
-        return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-    }
-};
-
-// ======================= Queen =======================
-class Queen : public Piece {
-public:
-    Queen(bool white) : Piece(white ? 'Q' : 'q', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        // rook-like
-        if (sr == er || sc == ec) {
-            int dr = (er > sr) ? 1 : (er < sr ? -1 : 0);
-            int dc = (ec > sc) ? 1 : (ec < sc ? -1 : 0);
-            int r = sr + dr, c = sc + dc;
-            while (r != er || c != ec) {
-                if (board[r][c] != nullptr) return false;
-                r += dr;c += dc;
-            }
-            return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-        }
-        // bishop-like
-        if (abs(er - sr) == abs(ec - sc)) {
-            int dr = (er > sr) ? 1 : -1, dc = (ec > sc) ? 1 : -1;
-            int r = sr + dr, c = sc + dc;
-            while (r != er && c != ec) {
-                if (board[r][c] != nullptr) return false;
-                r += dr;c += dc;
-            }
-            return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-        }
-        return false;
-    }
-};
-
-// ======================= King =======================
-class King : public Piece {
-public:
-    King(bool white) : Piece(white ? 'K' : 'k', white) {}
-    bool isValidMove(int sr, int sc, int er, int ec, Piece* board[8][8]) override {
-        int dr = abs(er - sr), dc = abs(ec - sc);
-        if (dr <= 1 && dc <= 1) {
-            return board[er][ec] == nullptr || board[er][ec]->getColor() != isWhite;
-        }
-        // Castling basic path clearance (attack checks handled in Board::movePiece)
-        if (dr == 0 && dc == 2 && !hasMoved) {
-            int rookCol = (ec > sc) ? 7 : 0;
-            Piece* rook = board[sr][rookCol];
-            if (rook != nullptr && dynamic_cast<Rook*>(rook) != nullptr && !rook->getHasMoved()) {
-                int step = (ec > sc) ? 1 : -1;
-                for (int c = sc + step;c != rookCol;c += step) {
-                    if (board[sr][c] != nullptr) return false;
-                }
-                return true;
-            }
-        }
-        return false;
-    }
-};
-
 // ======================= Board =======================
 class Board {
 private:
-    Piece* squares[8][8];
-    pair<int, int> lastMoveStart;
-    pair<int, int> lastMoveEnd;
+    Position pos;
+    Position startPos;          // position at setup/load, where `played` begins
+    vector<Move> played;        // moves since setup/load, for takeback
+    vector<UndoInfo> undoStack;
+    vector<uint64_t> keyHistory; // Zobrist key of every position since setup/load
 
     // Simpler glyph() function: just return the piece letter
     string glyph(char ch) {
         return string(1, ch);
     }
 
+    static Color colorFor(bool white) { return white ? WHITE : BLACK; }
+
 public:
     Board() {
-        for (int r = 0;r < 8;r++)for (int c = 0;c < 8;c++)squares[r][c] = nullptr;
-        lastMoveStart = { -1,-1 };
-        lastMoveEnd = { -1,-1 };
-    }
-    ~Board() {
-        for (int r = 0;r < 8;r++)for (int c = 0;c < 8;c++)delete squares[r][c];
+        pos.clear();
+        // A long game's worth, so playing a move does not reallocate
+        played.reserve(512);
+        undoStack.reserve(512);
+        keyHistory.reserve(512);
     }
     void setupBoard() {
-        for (int c = 0;c < 8;c++) {
-            squares[6][c] = new Pawn(true);
-            squares[1][c] = new Pawn(false);
-        }
-        squares[7][0] = new Rook(true);squares[7][7] = new Rook(true);
-        squares[0][0] = new Rook(false);squares[0][7] = new Rook(false);
-        squares[7][1] = new Knight(true);squares[7][6] = new Knight(true);
-        squares[0][1] = new Knight(false);squares[0][6] = new Knight(false);
-        squares[7][2] = new Bishop(true);squares[7][5] = new Bishop(true);
-        squares[0][2] = new Bishop(false);squares[0][5] = new Bishop(false);
-        squares[7][3] = new Queen(true);squares[0][3] = new Queen(false);
-        squares[7][4] = new King(true);squares[0][4] = new King(false);
+        pos.setStartPosition();
+        startPos = pos;
+        played.clear();
+        undoStack.clear();
+        keyHistory.assign(1, pos.key);
     }
 
     void display() {
@@ -192,8 +68,9 @@ public:
         for (int r = 0;r < 8;r++) {
             cout << "  " << (8 - r) << " |";
             for (int c = 0;c < 8;c++) {
-                if (squares[r][c] == nullptr) cout << "   |";
-                else cout << " " << glyph(squares[r][c]->getSymbol()) << " |";
+                Piece p = pos.pieceOn(makeSquare(r, c));
+                if (p == NO_PIECE) cout << "   |";
+                else cout << " " << glyph(pieceSymbol(p)) << " |";
             }
             cout << " " << (8 - r) << "\n";
             cout << "    +---+---+---+---+---+---+---+---+\n";
@@ -201,304 +78,160 @@ public:
         cout << "      a   b   c   d   e   f   g   h\n\n";
     }
 
-    Piece* getPiece(int r, int c) { return squares[r][c]; }
+    Piece getPiece(int r, int c) { return pos.pieceOn(makeSquare(r, c)); }
+    const Position& position() const { return pos; }
+    bool whiteToMove() const { return pos.sideToMove == WHITE; }
 
     pair<int, int> findKing(bool white) {
-        for (int r = 0;r < 8;r++) {
-            for (int c = 0;c < 8;c++) {
-                if (squares[r][c] != nullptr && dynamic_cast<King*>(squares[r][c]) != nullptr) {
-                    if (squares[r][c]->getColor() == white) return { r,c };
-                }
-            }
-        }
-        return { -1,-1 };
+        int k = pos.kingSquare(colorFor(white));
+        if (k == NO_SQUARE) return { -1,-1 };
+        return { rowOf(k),colOf(k) };
     }
 
     bool isSquareAttacked(int row, int col, bool byWhite) {
-        for (int r = 0;r < 8;r++) {
-            for (int c = 0;c < 8;c++) {
-                Piece* p = squares[r][c];
-                if (p != nullptr && p->getColor() == byWhite) {
-                    if (p->isValidMove(r, c, row, col, squares)) return true;
-                }
-            }
-        }
-        return false;
+        return pos.isAttacked(makeSquare(row, col), colorFor(byWhite));
     }
 
     bool isInCheck(bool white) {
-        auto kingPos = findKing(white);
-        return isSquareAttacked(kingPos.first, kingPos.second, !white);
+        return pos.inCheck(colorFor(white));
+    }
+
+    // Legal moves for the given side (the side to move unless told otherwise).
+    void legalMoves(bool white, MoveList& list) {
+        if (colorFor(white) == pos.sideToMove) { generateLegal(pos, list); return; }
+        Position other = pos;
+        other.sideToMove = colorFor(white);
+        other.epSquare = NO_SQUARE;
+        other.updateCheckInfo();
+        generateLegal(other, list);
     }
 
     bool hasLegalMoves(bool white) {
-        for (int sr = 0;sr < 8;sr++) {
-            for (int sc = 0;sc < 8;sc++) {
-                Piece* p = squares[sr][sc];
-                if (p != nullptr && p->getColor() == white) {
-                    for (int er = 0;er < 8;er++) {
-                        for (int ec = 0;ec < 8;ec++) {
-                            if (tryMove(sr, sc, er, ec, white)) return true;
-                        }
-                    }
-                }
-            }
+        if (colorFor(white) == pos.sideToMove) return ::hasLegalMoves(pos);
+        MoveList list;
+        legalMoves(white, list);
+        return list.size() > 0;
+    }
+
+    // Look up the legal move (sr, sc) -> (er, ec), or MOVE_NONE.
+    Move findMove(int sr, int sc, int er, int ec, bool whiteTurn, PieceType promotion = QUEEN) {
+        MoveList list;
+        legalMoves(whiteTurn, list);
+        int from = makeSquare(sr, sc), to = makeSquare(er, ec);
+        for (Move m : list) {
+            if (moveFrom(m) == from && moveTo(m) == to && (!isPromotion(m) || promotionType(m) == promotion))
+                return m;
         }
-        return false;
+        return MOVE_NONE;
     }
 
-    // Try a move by simulating it (including en passant and castling), then undo.
+    // Check a move (including en passant and castling) without playing it.
     bool tryMove(int sr, int sc, int er, int ec, bool whiteTurn) {
-        Piece* p = squares[sr][sc];
-        if (!p || p->getColor() != whiteTurn) return false;
-
-        // Handle en passant possibility in simulation
-        bool enPassant = false;
-        int ep_r = -1, ep_c = -1;
-        if (dynamic_cast<Pawn*>(p) != nullptr && abs(er - sr) == 1 && abs(ec - sc) == 1 && squares[er][ec] == nullptr) {
-            if (lastMoveStart.first != -1) {
-                int target_r = sr; // the captured pawn is on same row as moving pawn started
-                int target_c = ec;
-                Piece* adj = squares[target_r][target_c];
-                if (adj != nullptr && dynamic_cast<Pawn*>(adj) != nullptr) {
-                    if (abs(lastMoveEnd.first - lastMoveStart.first) == 2 &&
-                        lastMoveEnd.first == target_r && lastMoveEnd.second == target_c) {
-                        enPassant = true;
-                        ep_r = target_r; ep_c = target_c;
-                    }
-                }
-            }
-        }
+        return findMove(sr, sc, er, ec, whiteTurn) != MOVE_NONE;
+    }
 
-        // Validate basic move legality (piece rules)
-        if (!enPassant && !p->isValidMove(sr, sc, er, ec, squares)) return false;
+    bool movePiece(int sr, int sc, int er, int ec, bool whiteTurn, PieceType promotion = QUEEN) {
+        Move m = findMove(sr, sc, er, ec, whiteTurn, promotion);
+        if (m == MOVE_NONE) return false;
+        playMove(m);
+        return true;
+    }
 
-        // Save state
-        Piece* captured = squares[er][ec];
-        Piece* epCaptured = nullptr;
+    // Play a move taken from legalMoves().
+    void playMove(Move m) {
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        played.push_back(m);
+        undoStack.push_back(undo);
+        keyHistory.push_back(pos.key);
+    }
 
-        // Apply move
-        if (enPassant) {
-            epCaptured = squares[ep_r][ep_c];
-            squares[ep_r][ep_c] = nullptr;
-        }
-        squares[er][ec] = p;
-        squares[sr][sc] = nullptr;
-
-        // Additional castling safety checks: king not in, through, or into check
-        bool castle = dynamic_cast<King*>(p) != nullptr && abs(ec - sc) == 2;
-        bool legal = true;
-        if (castle) {
-            int step = (ec > sc) ? 1 : -1;
-            int midc = sc + step;
-            int row = er;
-            if (isInCheck(whiteTurn) || isSquareAttacked(row, midc, !whiteTurn) || isSquareAttacked(row, ec, !whiteTurn)) {
-                legal = false;
-            }
-        }
-        else {
-            legal = !isInCheck(whiteTurn);
-        }
+    // Take back the last move; false if there is nothing to take back
+    // (moves made before a load cannot be undone).
+    bool undoMove() {
+        if (played.empty()) return false;
+        pos.unmakeMove(played.back(), undoStack.back());
+        played.pop_back();
+        undoStack.pop_back();
+        keyHistory.pop_back();
+        return true;
+    }
 
-        // Undo move
-        squares[sr][sc] = p;
-        squares[er][ec] = captured;
-        if (enPassant && epCaptured) {
-            squares[ep_r][ep_c] = epCaptured;
+    // Earlier occurrences of the current position. Only positions since the
+    // last capture or pawn move, with the same side to move, can match.
+    int repetitions() {
+        int count = 0;
+        int last = (int)keyHistory.size() - 1;
+        int oldest = max(0, last - pos.halfmoveClock);
+        for (int i = last - 2;i >= oldest;i -= 2) {
+            if (keyHistory[i] == pos.key) count++;
         }
+        return count;
+    }
 
-        return legal;
-    }
-
-    bool movePiece(int sr, int sc, int er, int ec, bool whiteTurn) {
-        Piece* p = squares[sr][sc];
-        if (!p || p->getColor() != whiteTurn) return false;
-
-        // En Passant actual capture
-        bool didEnPassant = false;
-        if (dynamic_cast<Pawn*>(p) != nullptr && abs(er - sr) == 1 && abs(ec - sc) == 1 && squares[er][ec] == nullptr) {
-            if (lastMoveStart.first != -1) {
-                int target_r = sr;
-                int target_c = ec;
-                Piece* adj = squares[target_r][target_c];
-                if (adj != nullptr && dynamic_cast<Pawn*>(adj) != nullptr) {
-                    if (abs(lastMoveEnd.first - lastMoveStart.first) == 2 &&
-                        lastMoveEnd.first == target_r && lastMoveEnd.second == target_c) {
-                        // Validate that move doesn't leave king in check
-                        Piece* epCaptured = squares[target_r][target_c];
-                        squares[target_r][target_c] = nullptr;
-                        Piece* captured = squares[er][ec]; // should be null
-                        squares[er][ec] = p;
-                        squares[sr][sc] = nullptr;
-                        bool legal = !isInCheck(whiteTurn);
-                        // Undo
-                        squares[sr][sc] = p;
-                        squares[er][ec] = captured;
-                        squares[target_r][target_c] = epCaptured;
-                        if (!legal) return false;
-
-                        // Perform en passant
-                        delete squares[target_r][target_c];
-                        squares[target_r][target_c] = nullptr;
-                        squares[er][ec] = p;
-                        squares[sr][sc] = nullptr;
-                        p->setMoved();
-                        lastMoveStart = { sr,sc };
-                        lastMoveEnd = { er,ec };
-                        didEnPassant = true;
-                    }
-                }
-            }
-            if (didEnPassant) return true;
-        }
+    bool isThreefoldRepetition() { return repetitions() >= 2; }
 
-        // Validate piece rule
-        if (!p->isValidMove(sr, sc, er, ec, squares)) return false;
-
-        // Save captured
-        Piece* captured = squares[er][ec];
-
-        // Apply move
-        squares[er][ec] = p;
-        squares[sr][sc] = nullptr;
-
-        // Castling path safety (not in, through, into check)
-        if (dynamic_cast<King*>(p) != nullptr && abs(ec - sc) == 2) {
-            int step = (ec > sc) ? 1 : -1;
-            int midc = sc + step;
-            int row = er;
-            if (isInCheck(whiteTurn) || isSquareAttacked(row, midc, !whiteTurn) || isSquareAttacked(row, ec, !whiteTurn)) {
-                // Undo
-                squares[sr][sc] = p;
-                squares[er][ec] = captured;
-                return false;
-            }
-        }
+    const vector<uint64_t>& positionKeys() const { return keyHistory; }
 
-        // Check legality
-        bool legal = !isInCheck(whiteTurn);
-        if (!legal) {
-            squares[sr][sc] = p;
-            squares[er][ec] = captured;
-            return false;
-        }
+    // Set up a position from FEN; leaves the board untouched on bad input.
+    bool setFen(const string& fen) {
+        Position next;
+        if (!next.setFen(fen)) return false;
+        pos = next;
+        startPos = pos;
+        played.clear();
+        undoStack.clear();
+        keyHistory.assign(1, pos.key);
+        return true;
+    }
 
-        // Finalize capture
-        delete captured;
-        p->setMoved();
+    string fen() const { return pos.fen(); }
 
-        // Pawn promotion
-        if (dynamic_cast<Pawn*>(p) != nullptr) {
-            if ((p->getColor() && er == 0) || (!p->getColor() && er == 7)) {
-                delete squares[er][ec];
-                squares[er][ec] = new Queen(p->getColor());
-            }
-        }
+    const Position& startPosition() const { return startPos; }
+    const vector<Move>& movesPlayed() const { return played; }
 
-        // Castling: move rook too
-        if (dynamic_cast<King*>(p) != nullptr && abs(ec - sc) == 2) {
-            int rookCol = (ec > sc) ? 7 : 0;
-            int newRookCol = (ec > sc) ? ec - 1 : ec + 1;
-            Piece* rook = squares[er][rookCol];
-            squares[er][newRookCol] = rook;
-            squares[er][rookCol] = nullptr;
-            if (rook) rook->setMoved();
+    // PGN result tag for the current position: "*" while the game goes on.
+    string result() {
+        if (!hasLegalMoves(whiteToMove())) {
+            if (!isInCheck(whiteToMove())) return "1/2-1/2";
+            return whiteToMove() ? "0-1" : "1-0";
         }
-
-        lastMoveStart = { sr,sc };
-        lastMoveEnd = { er,ec };
-        return true;
+        if (isThreefoldRepetition() || pos.halfmoveClock >= 100) return "1/2-1/2";
+        return "*";
     }
 
-    // Save board and history to file
+    // Save the position as FEN, followed by the move history
     void saveGame(const string& filename, const vector<string>& history) {
         ofstream out(filename);
         if (!out) { cout << "Error saving file!\n"; return; }
-        for (int r = 0;r < 8;r++) {
-            for (int c = 0;c < 8;c++) {
-                if (squares[r][c] == nullptr) out << ".";
-                else out << squares[r][c]->getSymbol();
-            }
-            out << "\n";
-        }
-        out << "HISTORY\n";
-        for (auto& m : history) out << m << "\n";
+        writeSaveFile(out, pos, history);
         out.close();
         cout << "Game saved to " << filename << "\n";
     }
 
-    // Load board and history from file (marks pieces as moved to avoid castling ambiguity)
+    // Load board and history from file (either save format, see savefile.h)
     void loadGame(const string& filename, vector<string>& history) {
         ifstream in(filename);
         if (!in) { cout << "Error loading file!\n"; return; }
-        // Clear existing
-        for (int r = 0;r < 8;r++)for (int c = 0;c < 8;c++) { delete squares[r][c]; squares[r][c] = nullptr; }
-
-        // Read board
-        for (int r = 0;r < 8;r++) {
-            string line; getline(in, line);
-            if (line.size() < 8) { cout << "Invalid file format.\n"; return; }
-            for (int c = 0;c < 8;c++) {
-                char ch = line[c];
-                if (ch == '.') continue;
-                bool white = isupper(ch);
-                switch (toupper(ch)) {
-                case 'P': squares[r][c] = new Pawn(white); break;
-                case 'R': squares[r][c] = new Rook(white); break;
-                case 'N': squares[r][c] = new Knight(white); break;
-                case 'B': squares[r][c] = new Bishop(white); break;
-                case 'Q': squares[r][c] = new Queen(white); break;
-                case 'K': squares[r][c] = new King(white); break;
-                }
-                if (squares[r][c]) squares[r][c]->setHasMoved(true); // conservative choice
-            }
-        }
-        string marker; getline(in, marker);
-        history.clear();
-        string move;
-        while (getline(in, move)) {
-            if (move.size() == 4) history.push_back(move);
-        }
-        // Reset lastMove tracking from history if possible
-        if (!history.empty()) {
-            string last = history.back();
-            int sr = 8 - (last[1] - '0');
-            int sc = last[0] - 'a';
-            int er = 8 - (last[3] - '0');
-            int ec = last[2] - 'a';
-            lastMoveStart = { sr,sc };
-            lastMoveEnd = { er,ec };
-        }
-        else {
-            lastMoveStart = { -1,-1 };
-            lastMoveEnd = { -1,-1 };
-        }
+        Position loaded;
+        vector<string> moves;
+        if (!readSaveFile(in, loaded, moves)) { cout << "Invalid file format.\n"; return; }
+        pos = loaded;
+        startPos = pos;
+        played.clear();
+        undoStack.clear();
+        keyHistory.assign(1, pos.key);
+        history = moves;
         cout << "Game loaded from " << filename << "\n";
     }
 };
 
 // ======================= AI (Random Legal Move) =======================
-struct Move { int sr, sc, er, ec; };
-
 Move getRandomAIMove(Board& board, bool aiWhite) {
-    vector<Move> moves;
-    for (int sr = 0;sr < 8;sr++) {
-        for (int sc = 0;sc < 8;sc++) {
-            Piece* p = board.getPiece(sr, sc);
-            if (p != nullptr && p->getColor() == aiWhite) {
-                for (int er = 0;er < 8;er++) {
-                    for (int ec = 0;ec < 8;ec++) {
-                        if (board.tryMove(sr, sc, er, ec, aiWhite)) {
-                            moves.push_back({ sr,sc,er,ec });
-                        }
-                    }
-                }
-            }
-        }
-    }
-    if (moves.empty()) return { -1,-1,-1,-1 };
-    size_t idx = rand() % moves.size();
-    return moves[idx];
+    MoveList moves;
+    board.legalMoves(aiWhite, moves);
+    if (moves.size() == 0) return MOVE_NONE;
+    return moves[rand() % moves.size()];
 }
 
 // ======================= Game =======================
@@ -509,37 +242,115 @@ private:
     vector<string> history;
     bool aiEnabled;
     bool aiIsWhite;
-
+    bool aiSearches;            // alpha-beta search instead of random moves
+    SearchLimits aiLimits;
+    TranspositionTable tt;
+    SmpSearch searcher;         // Lazy SMP; one thread unless --threads says otherwise
+    OpeningBook book;           // consulted before the AI thinks; empty unless --book is given
+    Tablebases tablebases;      // endgames of up to 4 pieces, from --tb
+
+    // Home + erase instead of spawning "clear"/"cls" every turn; only when
+    // a person is watching, so piped output stays plain. The Windows console
+    // API works on every version, with or without VT processing.
     void clearScreen() {
 #ifdef _WIN32
-        system("cls");
+        if (!_isatty(_fileno(stdout))) return;
+        cout.flush();
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (!GetConsoleScreenBufferInfo(console, &info)) return;
+        DWORD cells = DWORD(info.dwSize.X) * info.dwSize.Y, written;
+        COORD home = { 0, 0 };
+        FillConsoleOutputCharacterA(console, ' ', cells, home, &written);
+        FillConsoleOutputAttribute(console, info.wAttributes, cells, home, &written);
+        SetConsoleCursorPosition(console, home);
 #else
-        system("clear");
+        if (isatty(STDOUT_FILENO)) cout << "\033[H\033[2J";
 #endif
     }
 
 public:
-    Game() :whiteTurn(true), aiEnabled(false), aiIsWhite(false) {
+    Game() :whiteTurn(true), aiEnabled(false), aiIsWhite(false), aiSearches(false) {
         board.setupBoard();
         srand((unsigned)time(0));
+        tt.resize(16);
+        searcher.setTable(&tt);
+    }
+
+    // Transposition table size for the searching AI
+    void setHashSize(size_t megabytes, bool hugePages) {
+        tt.resize(megabytes, hugePages);
+    }
+
+    // Number of threads the searching AI runs on
+    void setThreads(int threads) {
+        searcher.setThreads(threads);
+    }
+
+    // Memory-maps an opening book built by the "book" tool.
+    bool openBook(const string& path) {
+        return book.open(path);
+    }
+
+    // A weighted random book move for the current position, or MOVE_NONE.
+    Move getBookMove() {
+        if (!book.isOpen()) return MOVE_NONE;
+        uint64_t dice = ((uint64_t)rand() << 32) ^ ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+        return book.probe(board.position(), dice);
+    }
+
+    // Directory of tables built by tbgen; returns how many it holds.
+    int openTablebases(const string& dir) {
+        return tablebases.init(dir);
+    }
+
+    // The tablebase's best move when the position is covered, or MOVE_NONE.
+    Move getTablebaseMove() {
+        if (tablebases.tableCount() == 0) return MOVE_NONE;
+        TbEntry result;
+        Move m = tablebases.bestMove(board.position(), &result);
+        if (m == MOVE_NONE) return MOVE_NONE;
+        if (result.wdl > 0) cout << "Tablebase: mate in " << (result.plies + 1) / 2 << ".\n";
+        else if (result.wdl < 0) cout << "Tablebase: mated in " << result.plies / 2 << ".\n";
+        else cout << "Tablebase: draw.\n";
+        return m;
     }
 
-    void chooseMode() {
+    // False when the answer is "uci": a GUI has started the program.
+    bool chooseMode() {
         cout << "Select mode:\n";
         cout << "1) Human vs Human\n";
         cout << "2) Human vs AI\n";
-        cout << "Choice: ";
-        int choice; cin >> choice;
-        if (choice == 2) {
+        cout << "Choice: " << flush;
+        string choice; cin >> choice;
+        if (choice == "uci") return false;
+        if (choice == "2") {
             aiEnabled = true;
             cout << "Should AI play as (w)hite or (b)lack? ";
             char side; cin >> side;
             aiIsWhite = (side == 'w' || side == 'W');
             cout << "AI set to " << (aiIsWhite ? "White" : "Black") << ".\n";
+            cout << "AI type: 1) Random moves  2) Alpha-beta search\n";
+            cout << "Choice: ";
+            int type; cin >> type;
+            aiSearches = (type == 2);
+            if (aiSearches) {
+                cout << "Limit search by (d)epth or (t)ime? ";
+                char limit; cin >> limit;
+                if (limit == 'd' || limit == 'D') {
+                    cout << "Depth (plies): ";
+                    cin >> aiLimits.depth;
+                }
+                else {
+                    cout << "Milliseconds per move: ";
+                    cin >> aiLimits.movetimeMs;
+                }
+            }
         }
         else {
             aiEnabled = false;
         }
+        return true;
     }
 
     string moveToString(int sr, int sc, int er, int ec) {
@@ -551,33 +362,105 @@ public:
         return s;
     }
 
+    // Coordinate form, with a promotion suffix for under-promotions (e7e8n)
+    string moveToString(Move m) {
+        int from = moveFrom(m), to = moveTo(m);
+        string s = moveToString(rowOf(from), colOf(from), rowOf(to), colOf(to));
+        if (isPromotion(m) && promotionType(m) != QUEEN) s.push_back("nbrq"[promotionType(m) - KNIGHT]);
+        return s;
+    }
+
     void helpForSquare(const string& pos) {
         if (pos.size() != 2) { cout << "Usage: help e2\n"; return; }
         int sr = 8 - (pos[1] - '0');
         int sc = pos[0] - 'a';
         if (sr < 0 || sr>7 || sc < 0 || sc>7) { cout << "Invalid square.\n"; return; }
-        Piece* p = board.getPiece(sr, sc);
-        if (!p) { cout << "No piece at " << pos << ".\n"; return; }
-        if (p->getColor() != whiteTurn) {
+        Piece p = board.getPiece(sr, sc);
+        if (p == NO_PIECE) { cout << "No piece at " << pos << ".\n"; return; }
+        if ((colorOf(p) == WHITE) != whiteTurn) {
             cout << "It's " << (whiteTurn ? "White" : "Black") << "'s turn. Select your own piece.\n";
             return;
         }
         cout << "Possible moves for " << pos << ": ";
         bool any = false;
-        for (int er = 0;er < 8;er++) {
-            for (int ec = 0;ec < 8;ec++) {
-                if (board.tryMove(sr, sc, er, ec, whiteTurn)) {
-                    cout << char('a' + ec) << 8 - er << " ";
-                    any = true;
-                }
-            }
+        MoveList moves;
+        board.legalMoves(whiteTurn, moves);
+        int from = makeSquare(sr, sc);
+        for (Move m : moves) {
+            // Promotions list each destination once
+            if (moveFrom(m) != from || (isPromotion(m) && promotionType(m) != QUEEN)) continue;
+            cout << char('a' + colOf(moveTo(m))) << 8 - rowOf(moveTo(m)) << " ";
+            any = true;
         }
         if (!any) cout << "(none)";
         cout << "\n";
     }
 
-    void play() {
-        chooseMode();
+    // Best move from the alpha-beta searcher, printing each iteration's
+    // depth, score, node count, speed and principal variation.
+    Move getSearchAIMove() {
+        searcher.onIteration = [](const SearchInfo& info) {
+            cout << "depth " << info.depth << "  score " << scoreToString(info.score)
+                << "  nodes " << info.nodes << "  nps " << info.nps() << "  pv";
+            for (Move m : info.pv) cout << " " << moveToUci(m);
+            cout << "\n";
+        };
+        SearchInfo result = searcher.think(board.position(), board.positionKeys(), aiLimits);
+        cout << "tt hit rate " << int(result.ttHitRate()) << "%  fill " << result.hashfull / 10
+            << "%  pawn hash hit rate " << int(result.pawnHitRate()) << "%\n";
+        return result.bestMove();
+    }
+
+    // Book first, then tablebases, then the random or searching AI.
+    Move chooseAIMove() {
+        STATS_SCOPE(STAT_AI_MOVE);
+        Move m = getBookMove();
+        if (m != MOVE_NONE) {
+            cout << "Book move.\n";
+            return m;
+        }
+        m = getTablebaseMove();
+        if (m != MOVE_NONE) return m;
+        return aiSearches ? getSearchAIMove() : getRandomAIMove(board, aiIsWhite);
+    }
+
+    // Export the moves played since setup/load as PGN.
+    void savePgn(const string& filename) {
+        ofstream out(filename);
+        if (!out) { cout << "Error saving file!\n"; return; }
+        time_t now = time(0);
+        char date[16];
+        strftime(date, sizeof(date), "%Y.%m.%d", localtime(&now));
+        string white = aiEnabled && aiIsWhite ? "AI" : "Human";
+        string black = aiEnabled && !aiIsWhite ? "AI" : "Human";
+        string result = board.result();
+        PgnTagList tags = { { "Event", "Casual game" }, { "Site", "chessFinal" }, { "Date", date },
+            { "Round", "-" }, { "White", white }, { "Black", black }, { "Result", result } };
+        writePgn(out, tags, board.startPosition(), board.movesPlayed(), result);
+        cout << "Game saved to " << filename << "\n";
+    }
+
+    // Undo the last move; against the AI, undo its reply as well so the
+    // human is on move again.
+    void takeBack() {
+        int plies = 0;
+        do {
+            if (!board.undoMove()) break;
+            history.pop_back();
+            whiteTurn = !whiteTurn;
+            plies++;
+        } while (aiEnabled && whiteTurn == aiIsWhite);
+        if (plies == 0) {
+            cout << "Nothing to take back.\n";
+            cout << "Press Enter to continue...";
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            cin.get();
+        }
+    }
+
+    // Returns false if a UCI GUI answered the mode prompt instead of a person.
+    bool play() {
+        if (!chooseMode()) return false;
         while (true) {
             // Refresh screen each turn
             clearScreen();
@@ -596,16 +479,20 @@ public:
                 }
                 break;
             }
+            if (board.isThreefoldRepetition()) {
+                cout << "Draw by threefold repetition!\n";
+                break;
+            }
 
             // AI turn
             if (aiEnabled && whiteTurn == aiIsWhite) {
-                Move m = getRandomAIMove(board, aiIsWhite);
-                if (m.sr == -1) {
+                Move m = chooseAIMove();
+                if (m == MOVE_NONE) {
                     cout << "AI has no legal moves.\n";
                     break;
                 }
-                board.movePiece(m.sr, m.sc, m.er, m.ec, aiIsWhite);
-                history.push_back(moveToString(m.sr, m.sc, m.er, m.ec));
+                board.playMove(m);
+                history.push_back(moveToString(m));
                 cout << "AI played: " << history.back() << "\n";
                 whiteTurn = !whiteTurn;
                 continue;
@@ -613,19 +500,52 @@ public:
 
             // Human turn and commands
             cout << (whiteTurn ? "White" : "Black") << " to move.\n";
-            cout << "Enter move (e.g. e2e4), or commands: help e2 | save filename | load filename | quit\n";
-            string cmd; cin >> cmd;
-            if (cmd == "quit") break;
+            cout << "Enter move (e.g. e2e4), or commands: help e2 | undo | save filename | load filename | pgn filename | fen [FEN] | stats | quit\n";
+            string cmd;
+            if (!(cin >> cmd) || cmd == "quit") break;
+            if (cmd == "stats") {
+                // Counters so far, as JSON; all zero unless built with CHESS_STATS
+                writeStatsJson(cout);
+                cout << "Press Enter to continue...";
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                cin.get();
+                continue;
+            }
+            if (cmd == "undo") {
+                takeBack();
+                continue;
+            }
             if (cmd == "save") {
                 string fname; cin >> fname;
                 board.saveGame(fname, history);
                 continue;
             }
+            if (cmd == "pgn") {
+                string fname; cin >> fname;
+                savePgn(fname);
+                continue;
+            }
             if (cmd == "load") {
                 string fname; cin >> fname;
                 board.loadGame(fname, history);
-                // After load, set turn based on history count parity
-                whiteTurn = (history.size() % 2 == 0);
+                // The loaded position knows whose turn it is
+                whiteTurn = board.whiteToMove();
+                continue;
+            }
+            if (cmd == "fen") {
+                // "fen" alone prints the position; "fen <FEN>" sets it up
+                string fen; getline(cin, fen);
+                size_t start = fen.find_first_not_of(" \t");
+                if (start == string::npos) {
+                    cout << board.fen() << "\n";
+                    cout << "Press Enter to continue...";
+                    cin.get();
+                }
+                else if (board.setFen(fen.substr(start))) {
+                    history.clear();
+                    whiteTurn = board.whiteToMove();
+                }
+                else cout << "Invalid FEN!\n";
                 continue;
             }
             if (cmd == "help") {
@@ -639,7 +559,14 @@ public:
 
             // Otherwise treat as move
             string move = cmd;
-            if (move.size() != 4) { cout << "Invalid input!\n"; continue; }
+            if (move.size() != 4 && move.size() != 5) { cout << "Invalid input!\n"; continue; }
+            // Optional fifth letter picks the promotion piece (default queen)
+            PieceType promotion = QUEEN;
+            if (move.size() == 5) {
+                Piece promo = pieceFromSymbol(char(tolower(move[4])));
+                if (promo == NO_PIECE || typeOf(promo) == PAWN || typeOf(promo) == KING) { cout << "Invalid input!\n"; continue; }
+                promotion = typeOf(promo);
+            }
             int sr = 8 - (move[1] - '0');
             int sc = move[0] - 'a';
             int er = 8 - (move[3] - '0');
@@ -647,8 +574,10 @@ public:
             if (sr < 0 || sr>7 || sc < 0 || sc>7 || er < 0 || er>7 || ec < 0 || ec>7) {
                 cout << "Out of bounds!\n";continue;
             }
-            if (board.movePiece(sr, sc, er, ec, whiteTurn)) {
-                history.push_back(move);
+            Move m = board.findMove(sr, sc, er, ec, whiteTurn, promotion);
+            if (m != MOVE_NONE) {
+                board.playMove(m);
+                history.push_back(moveToString(m));
                 whiteTurn = !whiteTurn;
             }
             else {
@@ -664,12 +593,88 @@ public:
         for (size_t i = 0;i < history.size();i++) {
             cout << i + 1 << ". " << history[i] << "\n";
         }
+        return true;
     }
 };
 
 // ======================= Main =======================
-int main() {
-    Game game;
-    game.play();
+// --stats FILE: the counters at exit, as CSV when FILE ends in .csv
+void saveStats(const string& path) {
+    if (path.empty()) return;
+    if (!StatsEnabled) cerr << "Note: statistics are only collected when built with -DCHESS_STATS=ON\n";
+    if (!writeStatsFile(path)) cerr << "Cannot write " << path << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc > 1 && string(argv[1]) == "selfcheck") {
+        int errors = verifyAttackTables();
+        cout << "Attack tables: " << (errors ? to_string(errors) + " mismatches" : string("OK")) << "\n";
+        return errors ? 1 : 0;
+    }
+    // chessFinal serve [--socket PATH] [--workers N] [--sessions N] [--queue N] [--depth D]
+    //                  [--hash MB]   (per worker)   [--max-movetime MS] [--max-nodes N]   (caps on "go")
+    if (argc > 1 && string(argv[1]) == "serve") {
+#ifdef _WIN32
+        cerr << "Server mode needs a POSIX system\n";
+        return 1;
+#else
+        ServerOptions opt;
+        opt.workers = max(1, (int)thread::hardware_concurrency() - 1);
+        for (int i = 2;i < argc;i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--socket" && hasValue) opt.socketPath = argv[++i];
+            else if (arg == "--workers" && hasValue) opt.workers = atoi(argv[++i]);
+            else if (arg == "--sessions" && hasValue) opt.sessions = (size_t)atol(argv[++i]);
+            else if (arg == "--queue" && hasValue) opt.maxQueued = (size_t)atol(argv[++i]);
+            else if (arg == "--depth" && hasValue) opt.depth = max(1, min(atoi(argv[++i]), MAX_PLY - 1));
+            else if (arg == "--hash" && hasValue) opt.hashMb = (size_t)atoi(argv[++i]);
+            else if (arg == "--max-movetime" && hasValue) opt.maxMovetimeMs = atoll(argv[++i]);
+            else if (arg == "--max-nodes" && hasValue) opt.maxNodes = strtoull(argv[++i], nullptr, 10);
+            else { cerr << "Unknown option " << arg << "\n"; return 2; }
+        }
+        GameServer server(opt);
+        return server.run() ? 0 : 1;
+#endif
+    }
+    // chessFinal [uci] [--hash MB] [--hugepages] [--threads N] [--book FILE] [--tb DIR]
+    //             [--stats FILE]
+    size_t hashMb = 16;
+    bool hugePages = false;
+    bool uci = false;
+    int threads = 1;
+    string bookPath, tbDir, statsPath;
+    for (int i = 1;i < argc;i++) {
+        string arg = argv[i];
+        if (arg == "uci") uci = true;
+        else if (arg == "--hash" && i + 1 < argc) hashMb = (size_t)atoi(argv[++i]);
+        else if (arg == "--hugepages") hugePages = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg == "--book" && i + 1 < argc) bookPath = argv[++i];
+        else if (arg == "--tb" && i + 1 < argc) tbDir = argv[++i];
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+    }
+    if (!uci) {
+        Game game;
+        game.setHashSize(hashMb, hugePages);
+        game.setThreads(threads);
+        if (!bookPath.empty() && !game.openBook(bookPath)) cerr << bookPath << ": not an opening book, playing without one\n";
+        if (!tbDir.empty() && game.openTablebases(tbDir) == 0) cerr << tbDir << ": no tablebase files, playing without them\n";
+        if (game.play()) {
+            saveStats(statsPath);
+            return 0;
+        }
+    }
+
+    // Started by a GUI: either on the command line, or it sent "uci" to
+    // the mode prompt, which still needs its answer
+    UciEngine engine;
+    engine.setHashSize(hashMb);
+    engine.setThreads(threads);
+    if (!uci) engine.command("uci");
+    engine.loop(cin);
+    saveStats(statsPath);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include "evaluate.h"
+#if defined(__x86_64__) || defined(_M_X64)
+#define EVAL_HAS_AVX2_KERNEL
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile just the AVX2 kernel for AVX2 (and hardware
+// POPCNT), so the rest of the program still runs on any x86-64 CPU.
+#if defined(EVAL_HAS_AVX2_KERNEL) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#else
+#define AVX2_TARGET
+#endif
+
+// ======================= Batch Evaluation =======================
+// Scores an array of positions with the same result as evaluate() on each.
+// The AVX2 kernel splits the work into passes over a block of positions:
+// gather every piece's attack set, popcount all of them four at a time in
+// 256-bit registers, then fold the counts into mobility and king-attack
+// scores. Material and piece-square sums come from each Position's
+// incremental psq, so they cost nothing here. The scalar kernel is
+// evaluate() in a loop, for CPUs without AVX2.
+enum EvalKernel { KERNEL_SCALAR, KERNEL_AVX2 };
+
+inline bool cpuHasAvx2() {
+#if !defined(EVAL_HAS_AVX2_KERNEL)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSaves = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;   // OSXSAVE, YMM state enabled
+    bool popcnt = (info[2] & (1 << 23)) != 0;
+    __cpuidex(info, 7, 0);
+    return osSaves && popcnt && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+}
+
+inline EvalKernel bestEvalKernel() {
+    static const EvalKernel best = cpuHasAvx2() ? KERNEL_AVX2 : KERNEL_SCALAR;
+    return best;
+}
+
+inline const char* evalKernelName(EvalKernel k) { return k == KERNEL_AVX2 ? "avx2" : "scalar"; }
+
+#if defined(EVAL_HAS_AVX2_KERNEL)
+const int EvalBlock = 32;                   // positions per pass
+const int MaxMobilityPieces = 32;           // knights to queens, both sides, with promotions
+
+// Bits set in each of four 64-bit lanes: per-nibble table lookup, then a
+// horizontal byte sum (Mula's method).
+AVX2_TARGET inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, lowNibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// Up to EvalBlock positions; every buffer is on the stack.
+AVX2_TARGET inline void evaluateBlockAvx2(const Position* positions, int n, int* out, PawnHashTable* pawnTable) {
+    alignas(32) Bitboard mobility[EvalBlock * MaxMobilityPieces];   // attacks & safe squares
+    alignas(32) Bitboard zone[EvalBlock * MaxMobilityPieces];       // attacks & enemy king zone
+    uint8_t type[EvalBlock * MaxMobilityPieces];
+    uint8_t owner[EvalBlock * MaxMobilityPieces];                   // position * 2 + colour
+    Score scores[EvalBlock];
+    int phases[EvalBlock];
+    bool scalar[EvalBlock];         // more pieces on a side than its slots: scored by evaluate()
+
+    // Pass 1: everything but mobility, and the attack sets to count
+    int entries = 0;
+    for (int i = 0;i < n;i++) {
+        const Position& pos = positions[i];
+        PawnEval local;
+        const PawnEval* pawns = &local;
+        if (pawnTable) pawns = &pawnTable->probe(pos);
+        else evaluatePawns(pos, local);
+        Score s = pos.psq + pawns->score;
+        s += passedPawnPaths(pos, *pawns, WHITE) - passedPawnPaths(pos, *pawns, BLACK);
+        s += kingShelter(pos, WHITE) - kingShelter(pos, BLACK);
+        scores[i] = s;
+        phases[i] = gamePhase(pos);
+
+        Bitboard occ = pos.occupied();
+        int positionFirst = entries;
+        bool overflow = false;
+        for (int c = WHITE;c <= BLACK && !overflow;c++) {
+            Color us = Color(c), them = !us;
+            Bitboard theirPawns = pos.pieces(them, PAWN);
+            Bitboard pawnCovered = them == WHITE ? ((theirPawns & ~FileABB) >> 9) | ((theirPawns & ~FileHBB) >> 7)
+                                                 : ((theirPawns & ~FileABB) << 7) | ((theirPawns & ~FileHBB) << 9);
+            Bitboard safe = ~pos.pieces(us) & ~pawnCovered;
+            int theirKing = pos.kingSquare(them);
+            Bitboard kingZone = theirKing != NO_SQUARE ? kingAttacks(theirKing) | squareBB(theirKing) : 0;
+            int first = entries;
+            for (int t = KNIGHT;t <= QUEEN;t++) {
+                for (Bitboard b = pos.pieces(us, PieceType(t));b;) {
+                    if (entries - first == MaxMobilityPieces / 2) { overflow = true; break; }
+                    Bitboard att = attacksFrom(PieceType(t), us, popLsb(b), occ);
+                    mobility[entries] = att & safe;
+                    zone[entries] = att & kingZone;
+                    type[entries] = uint8_t(t);
+                    owner[entries] = uint8_t(i * 2 + c);
+                    entries++;
+                }
+            }
+        }
+        scalar[i] = overflow;
+        if (overflow) entries = positionFirst;
+    }
+
+    // Pass 2: popcount every gathered set, four per instruction
+    int padded = (entries + 3) & ~3;
+    for (int e = entries;e < padded;e++) mobility[e] = zone[e] = 0;
+    for (int e = 0;e < padded;e += 4) {
+        __m256i m = popcount256(_mm256_load_si256((const __m256i*)(mobility + e)));
+        __m256i z = popcount256(_mm256_load_si256((const __m256i*)(zone + e)));
+        _mm256_store_si256((__m256i*)(mobility + e), m);
+        _mm256_store_si256((__m256i*)(zone + e), z);
+    }
+
+    // Pass 3: fold the counts in, exactly as evaluatePieces() does
+    Score mobilityScore[EvalBlock * 2] = {};
+    int attackers[EvalBlock * 2] = {}, attackWeight[EvalBlock * 2] = {};
+    for (int e = 0;e < entries;e++) {
+        int t = type[e], o = owner[e];
+        mobilityScore[o] += MobilityWeight[t] * (int(mobility[e]) - MobilityBase[t]);
+        if (zone[e]) {
+            attackers[o]++;
+            attackWeight[o] += KingAttackWeight[t] * int(zone[e]);
+        }
+    }
+    for (int i = 0;i < n;i++) {
+        Score s = scores[i];
+        for (int c = WHITE;c <= BLACK;c++) {
+            int o = i * 2 + c;
+            Score side = mobilityScore[o];
+            if (attackers[o] >= 2) {
+                int danger = attackWeight[o] * attackers[o];
+                side += makeScore(danger < 400 ? danger : 400, 0);
+            }
+            s += c == WHITE ? side : -side;
+        }
+        int v = taper(s, phases[i]);
+        out[i] = positions[i].sideToMove == WHITE ? v : -v;
+    }
+    for (int i = 0;i < n;i++) {
+        if (scalar[i]) out[i] = evaluate(positions[i], pawnTable);
+    }
+}
+#endif
+
+// out[i] = evaluate(positions[i]) for i < count.
+inline void evaluateBatch(const Position* positions, size_t count, int* out,
+                          PawnHashTable* pawnTable = nullptr, EvalKernel kernel = bestEvalKernel()) {
+#if defined(EVAL_HAS_AVX2_KERNEL)
+    if (kernel == KERNEL_AVX2) {
+        for (size_t i = 0;i < count;i += EvalBlock) {
+            int n = count - i < (size_t)EvalBlock ? int(count - i) : EvalBlock;
+            evaluateBlockAvx2(positions + i, n, out + i, pawnTable);
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0;i < count;i++) out[i] = evaluate(positions[i], pawnTable);
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <vector>
+#include "position.h"
+
+// ======================= Evaluation =======================
+// Centipawn values indexed by PieceType; the king is never traded. Used for
+// move ordering; the evaluator itself reads the tapered values in psqt.h.
+const int PieceValue[6] = { 100, 320, 330, 500, 900, 0 };
+
+// Game phase counts the minor and major pieces left: 24 at the start,
+// 0 with only kings and pawns. Scores blend from middlegame to endgame.
+const int PhaseWeight[6] = { 0, 1, 1, 2, 4, 0 };
+const int MaxPhase = 24;
+
+inline int gamePhase(const Position& pos) {
+    int phase = 0;
+    for (int t = KNIGHT;t <= QUEEN;t++) {
+        phase += PhaseWeight[t] * popCount(pos.pieces(WHITE, PieceType(t)) | pos.pieces(BLACK, PieceType(t)));
+    }
+    return phase < MaxPhase ? phase : MaxPhase;
+}
+
+// ----- Pawn masks -----
+constexpr Bitboard fileBB(int col) { return FileABB << col; }
+
+struct PawnMaskTable {
+    Bitboard adjacentFiles[8];
+    Bitboard forwardFile[2][64];    // squares ahead of a pawn on its own file
+    Bitboard passed[2][64];         // squares enemy pawns must avoid for a pawn to be passed
+};
+
+constexpr PawnMaskTable buildPawnMasks() {
+    PawnMaskTable t{};
+    for (int c = 0;c < 8;c++) {
+        t.adjacentFiles[c] = (c > 0 ? fileBB(c - 1) : 0) | (c < 7 ? fileBB(c + 1) : 0);
+    }
+    for (int sq = 0;sq < 64;sq++) {
+        int r = sq / 8, c = sq % 8;
+        for (int r2 = 0;r2 < 8;r2++) {
+            Bitboard row = fileBB(c) & (Rank8BB << (8 * r2));
+            Bitboard wide = (fileBB(c) | t.adjacentFiles[c]) & (Rank8BB << (8 * r2));
+            if (r2 < r) { t.forwardFile[WHITE][sq] |= row; t.passed[WHITE][sq] |= wide; }
+            if (r2 > r) { t.forwardFile[BLACK][sq] |= row; t.passed[BLACK][sq] |= wide; }
+        }
+    }
+    return t;
+}
+
+inline constexpr PawnMaskTable PawnMasks = buildPawnMasks();
+
+// Rank counted from the side's own back rank: 1 for a pawn on its start square.
+inline int relativeRank(Color c, int sq) { return c == WHITE ? 7 - rowOf(sq) : rowOf(sq); }
+
+// ----- Weights -----
+const Score DoubledPawn = makeScore(-10, -20);
+const Score IsolatedPawn = makeScore(-10, -15);
+const Score PassedPawnBonus[8] = {
+    makeScore(0, 0), makeScore(5, 10), makeScore(10, 20), makeScore(15, 35),
+    makeScore(30, 60), makeScore(50, 100), makeScore(80, 150), makeScore(0, 0) };
+const Score ShieldPawn[3] = { makeScore(0, 0), makeScore(12, 0), makeScore(6, 0) };   // by distance ahead of the king
+
+// Per attacked square beyond a typical count, for knight, bishop, rook, queen
+const Score MobilityWeight[6] = { 0, makeScore(4, 4), makeScore(5, 5), makeScore(2, 4), makeScore(1, 2), 0 };
+const int MobilityBase[6] = { 0, 4, 7, 7, 14, 0 };
+const int KingAttackWeight[6] = { 0, 2, 2, 3, 5, 0 };
+
+// ======================= Pawn Structure =======================
+// Doubled, isolated and passed pawns, White positive. Depends on pawn
+// placement only, so the result can be cached by a pawn-only key.
+struct PawnEval {
+    Score score;
+    Bitboard passed[2];
+};
+
+inline void evaluatePawns(const Position& pos, PawnEval& out) {
+    out.score = 0;
+    for (int c = WHITE;c <= BLACK;c++) {
+        Color us = Color(c);
+        Bitboard ours = pos.pieces(us, PAWN), theirs = pos.pieces(!us, PAWN);
+        Score s = 0;
+        out.passed[us] = 0;
+        for (Bitboard b = ours;b;) {
+            int sq = popLsb(b);
+            if (PawnMasks.forwardFile[us][sq] & ours) s += DoubledPawn;
+            if (!(PawnMasks.adjacentFiles[colOf(sq)] & ours)) s += IsolatedPawn;
+            if (!(PawnMasks.passed[us][sq] & theirs) && !(PawnMasks.forwardFile[us][sq] & ours)) {
+                out.passed[us] |= squareBB(sq);
+                s += PassedPawnBonus[relativeRank(us, sq)];
+            }
+        }
+        out.score += us == WHITE ? s : -s;
+    }
+}
+
+// ======================= Pawn Hash Table =======================
+// Pawns move far less often than pieces, so most positions in a search
+// share their pawn structure with one evaluated before. Results are cached
+// by the pawn-only key. Each search thread owns its table; no locking.
+struct PawnEntry {
+    uint64_t key;
+    PawnEval eval;
+};
+
+class PawnHashTable {
+public:
+    uint64_t probes, hits;
+
+    explicit PawnHashTable(size_t entries = 16384) : probes(0), hits(0) {
+        size_t n = 1;
+        while (n * 2 <= entries) n *= 2;
+        table.assign(n, PawnEntry());
+        for (PawnEntry& e : table) e.key = ~0ULL;   // no real pawn key is all ones
+        mask = n - 1;
+    }
+
+    // Evaluates and stores on a miss.
+    const PawnEval& probe(const Position& pos) {
+        probes++;
+        PawnEntry& e = table[pos.pawnKey & mask];
+        if (e.key == pos.pawnKey) { hits++; return e.eval; }
+        evaluatePawns(pos, e.eval);
+        e.key = pos.pawnKey;
+        return e.eval;
+    }
+
+    double hitRate() const { return probes ? 100.0 * hits / probes : 0.0; }
+
+private:
+    std::vector<PawnEntry> table;
+    size_t mask;
+};
+
+// ======================= Pieces and King Safety =======================
+// Mobility of knights, bishops, rooks and queens counts squares not held
+// by our own pieces or covered by enemy pawns. Pieces that reach the
+// squares around the enemy king add to an attack score that grows with
+// the number of attackers.
+inline Score evaluatePieces(const Position& pos, Color us) {
+    Color them = !us;
+    Bitboard occ = pos.occupied();
+    Bitboard theirPawns = pos.pieces(them, PAWN);
+    Bitboard pawnCovered = them == WHITE ? ((theirPawns & ~FileABB) >> 9) | ((theirPawns & ~FileHBB) >> 7)
+                                         : ((theirPawns & ~FileABB) << 7) | ((theirPawns & ~FileHBB) << 9);
+    Bitboard safe = ~pos.pieces(us) & ~pawnCovered;
+    int theirKing = pos.kingSquare(them);
+    Bitboard kingZone = theirKing != NO_SQUARE ? kingAttacks(theirKing) | squareBB(theirKing) : 0;
+
+    Score s = 0;
+    int attackers = 0, attackWeight = 0;
+    for (int t = KNIGHT;t <= QUEEN;t++) {
+        for (Bitboard b = pos.pieces(us, PieceType(t));b;) {
+            Bitboard att = attacksFrom(PieceType(t), us, popLsb(b), occ);
+            s += MobilityWeight[t] * (popCount(att & safe) - MobilityBase[t]);
+            if (att & kingZone) {
+                attackers++;
+                attackWeight += KingAttackWeight[t] * popCount(att & kingZone);
+            }
+        }
+    }
+    // A lone attacker is rarely dangerous
+    if (attackers >= 2) {
+        int danger = attackWeight * attackers;
+        s += makeScore(danger < 400 ? danger : 400, 0);
+    }
+    return s;
+}
+
+// Own pawns on the three files around the king, one or two ranks ahead.
+// Only counted while the king is still on its first two ranks.
+inline Score kingShelter(const Position& pos, Color us) {
+    int k = pos.kingSquare(us);
+    if (k == NO_SQUARE || relativeRank(us, k) > 1) return 0;
+    Bitboard pawns = pos.pieces(us, PAWN) & (fileBB(colOf(k)) | PawnMasks.adjacentFiles[colOf(k)]);
+    Score s = 0;
+    for (Bitboard b = pawns;b;) {
+        int sq = popLsb(b);
+        int ahead = relativeRank(us, sq) - relativeRank(us, k);
+        if (ahead >= 1 && ahead <= 2) s += ShieldPawn[ahead];
+    }
+    return s;
+}
+
+// A passed pawn whose next square is empty can keep running; worth most
+// in the endgame and the further it has come.
+const Score PassedFreePath[8] = {
+    makeScore(0, 0), makeScore(0, 5), makeScore(0, 10), makeScore(5, 20),
+    makeScore(10, 35), makeScore(15, 55), makeScore(20, 80), makeScore(0, 0) };
+
+inline Score passedPawnPaths(const Position& pos, const PawnEval& pawns, Color us) {
+    Score s = 0;
+    for (Bitboard b = pawns.passed[us];b;) {
+        int sq = popLsb(b);
+        int ahead = us == WHITE ? sq - 8 : sq + 8;
+        if (!(pos.occupied() & squareBB(ahead))) s += PassedFreePath[relativeRank(us, sq)];
+    }
+    return s;
+}
+
+// Blend a packed score by game phase.
+inline int taper(Score s, int phase) {
+    return (mgValue(s) * phase + egValue(s) * (MaxPhase - phase)) / MaxPhase;
+}
+
+// Static score in centipawns from the side to move's point of view.
+// Material and piece-square terms come from the incremental pos.psq; the
+// pawn structure comes from pawnTable when one is given.
+inline int evaluate(const Position& pos, PawnHashTable* pawnTable = nullptr) {
+    Score s = pos.psq;
+    PawnEval local;
+    const PawnEval* pawns = &local;
+    if (pawnTable) pawns = &pawnTable->probe(pos);
+    else evaluatePawns(pos, local);
+    s += pawns->score;
+    s += passedPawnPaths(pos, *pawns, WHITE) - passedPawnPaths(pos, *pawns, BLACK);
+    s += evaluatePieces(pos, WHITE) - evaluatePieces(pos, BLACK);
+    s += kingShelter(pos, WHITE) - kingShelter(pos, BLACK);
+    int v = taper(s, gamePhase(pos));
+    return pos.sideToMove == WHITE ? v : -v;
+}
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include "gamefile.h"
+#include "pgn.h"
+#include "savefile.h"
+#include "evaluate.h"
+using namespace std;
+
+// ======================= Converters =======================
+int fromPgn(const string& in, const string& out) {
+    MappedFile file;
+    if (!file.open(in, true)) { cerr << "Cannot open " << in << "\n"; return 1; }
+    GameArchiveWriter writer;
+    if (!writer.open(out)) { cerr << "Cannot create " << out << "\n"; return 1; }
+    PgnReader reader(file.view());
+    reader.onError = [](const PgnError& e) { cerr << "offset " << e.offset << ": " << e.message << "\n"; };
+    PgnGame game;
+    uint64_t unstored = 0;
+    while (reader.next(game)) {
+        if (!writer.add(game.start, game.moves, resultFromString(game.result))) {
+            cerr << "offset " << game.offset << ": game too long or start position over 32 pieces, not stored\n";
+            unstored++;
+        }
+    }
+    uint64_t games = writer.count();
+    if (!writer.close()) { cerr << "Error writing " << out << "\n"; return 1; }
+    cerr << games << " games written, " << reader.badGames + unstored << " bad games skipped\n";
+    return 0;
+}
+
+// Replays game n from its start position, stored into `start`, and
+// returns how many of its plies are legal; a damaged or hand-edited record
+// is cut short there and reported, since the moves go straight to
+// applyMove(). -1 when the start position itself is corrupt.
+int legalPlies(const GameView& g, uint64_t n, Position& start) {
+    if (!g.startPosition(start)) {
+        cerr << "game " << n << ": corrupt start position\n";
+        return -1;
+    }
+    Position pos = start;
+    for (int i = 0;i < g.plies;i++) {
+        if (!isLegalMove(pos, g.moves[i])) {
+            cerr << "game " << n << ": illegal move at ply " << i << "\n";
+            return i;
+        }
+        pos.applyMove(g.moves[i]);
+    }
+    return g.plies;
+}
+
+bool writeGamePgn(ostream& out, const GameView& g, uint64_t n) {
+    Position start;
+    int plies = legalPlies(g, n, start);
+    if (plies < 0) return false;
+    string result = resultString(g.result);
+    PgnTagList tags = { { "Event", "?" }, { "Site", "?" }, { "Date", "????.??.??" },
+        { "Round", to_string(n + 1) }, { "White", "?" }, { "Black", "?" }, { "Result", result } };
+    writePgn(out, tags, start, vector<Move>(g.moves, g.moves + plies), result);
+    return true;
+}
+
+int toPgn(const GameArchive& archive, uint64_t first, uint64_t last) {
+    GameView g;
+    for (uint64_t n = first;n < last;n++) {
+        if (!archive.game(n, g) || !writeGamePgn(cout, g, n)) { cerr << "Game " << n << " is damaged\n"; return 1; }
+    }
+    return 0;
+}
+
+// Save files list every move from the game's start; when that history
+// replays from the initial position to the saved one, the whole game is
+// kept, otherwise just the saved position.
+int fromSave(const string& out, const vector<string>& saves) {
+    GameArchiveWriter writer;
+    if (!writer.open(out)) { cerr << "Cannot create " << out << "\n"; return 1; }
+    for (const string& path : saves) {
+        ifstream in(path);
+        Position saved;
+        vector<string> history;
+        if (!in || !readSaveFile(in, saved, history)) { cerr << path << ": not a save file\n"; continue; }
+        Position pos;
+        pos.setStartPosition();
+        vector<Move> moves;
+        for (const string& h : history) {
+            Move m = parseSan(pos, h);
+            if (m == MOVE_NONE) break;
+            moves.push_back(m);
+            pos.applyMove(m);
+        }
+        Position initial;
+        initial.setStartPosition();
+        bool stored = moves.size() == history.size() && pos.key == saved.key
+            ? writer.add(initial, moves, RESULT_NONE) : writer.add(saved, vector<Move>(), RESULT_NONE);
+        if (!stored) cerr << path << ": position over 32 pieces, not stored\n";
+    }
+    uint64_t games = writer.count();
+    if (!writer.close()) { cerr << "Error writing " << out << "\n"; return 1; }
+    cerr << games << " games written\n";
+    return 0;
+}
+
+int toSave(const GameArchive& archive, uint64_t n, const string& out) {
+    GameView g;
+    if (!archive.game(n, g)) { cerr << "No game " << n << "\n"; return 1; }
+    Position pos;
+    int plies = legalPlies(g, n, pos);
+    if (plies < 0) return 1;
+    vector<string> history;
+    for (int i = 0;i < plies;i++) {
+        history.push_back(moveToUci(g.moves[i]));
+        pos.applyMove(g.moves[i]);
+    }
+    ofstream file(out);
+    if (!file) { cerr << "Cannot create " << out << "\n"; return 1; }
+    writeSaveFile(file, pos, history);
+    return 0;
+}
+
+// Every position from ply `skip` on, scored by the static evaluation and
+// tagged with the game's result.
+int toPositions(const GameArchive& archive, const string& out, int skip) {
+    PositionArchiveWriter writer;
+    if (!writer.open(out)) { cerr << "Cannot create " << out << "\n"; return 1; }
+    PawnHashTable pawnTable;
+    GameView g;
+    for (uint64_t n = 0;n < archive.size();n++) {
+        if (!archive.game(n, g)) continue;
+        Position pos;
+        int plies = legalPlies(g, n, pos);
+        if (plies < 0) continue;
+        for (int i = 0;i <= plies;i++) {
+            if (i >= skip) {
+                int score = evaluate(pos, &pawnTable);
+                PackedPosition pp;
+                if (packPosition(pos, pp, pos.sideToMove == WHITE ? score : -score, g.result)) writer.add(pp);
+            }
+            if (i < plies) pos.applyMove(g.moves[i]);
+        }
+    }
+    uint64_t positions = writer.count();
+    if (!writer.close()) { cerr << "Error writing " << out << "\n"; return 1; }
+    cerr << positions << " positions written\n";
+    return 0;
+}
+
+// Size per game and the cost of random access to game N.
+int stats(const GameArchive& archive) {
+    uint64_t plies = 0, damaged = 0;
+    GameView g;
+    Position first;
+    for (uint64_t n = 0;n < archive.size();n++) {
+        if (archive.game(n, g) && g.startPosition(first)) plies += g.plies;
+        else damaged++;
+    }
+    cout << archive.size() << " games, " << plies << " plies, " << archive.bytes() << " bytes ("
+        << (archive.size() ? archive.bytes() / archive.size() : 0) << " bytes/game)";
+    if (damaged) cout << ", " << damaged << " damaged";
+    cout << "\n";
+    if (archive.size() == 0) return 0;
+
+    const int lookups = 1000000;
+    uint64_t seed = 0x2545F4914F6CDD1DULL, sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0;i < lookups;i++) {
+        seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+        if (archive.game((seed * 2685821657736338717ULL) % archive.size(), g)) sink += g.plies ? g.moves[0] : 0;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "random access: " << (secs * 1e9 / lookups) << " ns/game  (checksum " << sink << ")\n";
+    return 0;
+}
+
+void usage() {
+    cerr << "Usage: gamedb frompgn <in.pgn> <out.cgf>\n"
+        << "       gamedb topgn <in.cgf>                      all games as PGN on stdout\n"
+        << "       gamedb get <in.cgf> <N>                    game N (from 0) as PGN\n"
+        << "       gamedb fromsave <out.cgf> <save files...>\n"
+        << "       gamedb tosave <in.cgf> <N> <save file>\n"
+        << "       gamedb positions <in.cgf> <out.cpf> [skip plies]\n"
+        << "       gamedb stats <in.cgf>\n";
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc < 3) { usage(); return 2; }
+    string mode = argv[1];
+    if (mode == "frompgn" && argc == 4) return fromPgn(argv[2], argv[3]);
+    if (mode == "fromsave" && argc >= 4) return fromSave(argv[2], vector<string>(argv + 3, argv + argc));
+
+    GameArchive archive;
+    if (!archive.open(argv[2])) { cerr << argv[2] << ": not a game archive\n"; return 1; }
+    if (mode == "topgn" && argc == 3) return toPgn(archive, 0, archive.size());
+    if (mode == "get" && argc == 4) {
+        uint64_t n = strtoull(argv[3], nullptr, 10);
+        if (n >= archive.size()) { cerr << "No game " << n << "\n"; return 1; }
+        return toPgn(archive, n, n + 1);
+    }
+    if (mode == "tosave" && argc == 5) return toSave(archive, strtoull(argv[3], nullptr, 10), argv[4]);
+    if (mode == "positions" && (argc == 4 || argc == 5)) return toPositions(archive, argv[3], argc == 5 ? atoi(argv[4]) : 0);
+    if (mode == "stats" && argc == 3) return stats(archive);
+    usage();
+    return 2;
+}
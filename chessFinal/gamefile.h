@@ -0,0 +1,303 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mmap.h"
+#include "position.h"
+
+// ======================= Results =======================
+enum GameResult : uint8_t { RESULT_NONE, WHITE_WINS, BLACK_WINS, DRAWN };
+
+inline const char* resultString(GameResult r) {
+    static const char* names[4] = { "*", "1-0", "0-1", "1/2-1/2" };
+    return names[r & 3];
+}
+
+inline GameResult resultFromString(std::string_view s) {
+    if (s == "1-0") return WHITE_WINS;
+    if (s == "0-1") return BLACK_WINS;
+    if (s == "1/2-1/2") return DRAWN;
+    return RESULT_NONE;
+}
+
+// ======================= Packed Positions =======================
+// 32 bytes: the occupancy, then one 4-bit Piece per occupied square in
+// square order (at most 32 pieces), then the state. The result and score
+// fields make it a training record; plain positions leave them zero.
+struct PackedPosition {
+    uint64_t occupied;
+    uint8_t pieces[16];
+    uint8_t state;              // bit 0: Black to move, bits 1-4: castling rights
+    int8_t epSquare;            // NO_SQUARE when there is none
+    uint8_t halfmoveClock;      // saturates at 255
+    uint8_t result;             // GameResult of the game it came from
+    uint16_t fullmoveNumber;
+    int16_t score;              // evaluation in centipawns, White's view
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+// False for a position with more than 32 pieces, which setFen() accepts
+// but the record cannot hold.
+inline bool packPosition(const Position& pos, PackedPosition& pp, int score = 0, GameResult result = RESULT_NONE) {
+    memset(&pp, 0, sizeof(pp));
+    pp.occupied = pos.occupied();
+    if (popCount(pp.occupied) > 32) return false;
+    int n = 0;
+    for (Bitboard b = pp.occupied;b;n++) {
+        int p = pos.pieceOn(popLsb(b));
+        pp.pieces[n / 2] |= uint8_t(p << (4 * (n & 1)));
+    }
+    pp.state = uint8_t((pos.sideToMove == BLACK ? 1 : 0) | (pos.castling << 1));
+    pp.epSquare = int8_t(pos.epSquare);
+    pp.halfmoveClock = uint8_t(pos.halfmoveClock < 255 ? pos.halfmoveClock : 255);
+    pp.result = result;
+    pp.fullmoveNumber = uint16_t(pos.fullmoveNumber);
+    pp.score = int16_t(score);
+    return true;
+}
+
+// False if the record could not have come from packPosition(): a bad
+// piece code, an en-passant square no double push could have left, or a
+// board setFen() would refuse (see Position::isPlausible()).
+inline bool unpackPosition(const PackedPosition& pp, Position& pos) {
+    pos.clear();
+    if (popCount(pp.occupied) > 32) return false;
+    int n = 0;
+    for (Bitboard b = pp.occupied;b;n++) {
+        int p = (pp.pieces[n / 2] >> (4 * (n & 1))) & 15;
+        if (p >= NO_PIECE) return false;
+        pos.putPiece(Piece(p), popLsb(b));
+    }
+    pos.sideToMove = (pp.state & 1) ? BLACK : WHITE;
+    pos.castling = (pp.state >> 1) & ALL_CASTLING;
+    if (pp.epSquare >= 0 && pp.epSquare < 64) {
+        if (!pos.couldBeEpSquare(pp.epSquare)) return false;
+        pos.setEpSquare(pp.epSquare);
+    }
+    pos.halfmoveClock = pp.halfmoveClock;
+    pos.fullmoveNumber = pp.fullmoveNumber ? pp.fullmoveNumber : 1;
+    pos.key = pos.computeKey();
+    pos.updateCheckInfo();
+    return pos.isPlausible();
+}
+
+// ======================= Game Archive =======================
+// Binary game file, in host byte order (little-endian on every target):
+//   header   magic "CHSGAMES", version, game count, index offset (32 bytes)
+//   records  plies (u16), result (u8), flags (u8), [PackedPosition start],
+//            then one 16-bit Move per ply
+//   index    one u64 file offset per game, so game N is found in O(1)
+// A record only carries a start position when the game did not begin from
+// the initial one. A typical game of 80 plies takes 164 bytes.
+const char GameArchiveMagic[8] = { 'C', 'H', 'S', 'G', 'A', 'M', 'E', 'S' };
+const uint32_t GameArchiveVersion = 1;
+const uint8_t RECORD_HAS_START = 1;
+
+struct GameArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t gameCount;
+    uint64_t indexOffset;
+};
+
+static_assert(sizeof(GameArchiveHeader) == 32, "GameArchiveHeader must stay 32 bytes");
+
+class GameArchiveWriter {
+public:
+    GameArchiveWriter() : file(nullptr), at(0) {}
+    ~GameArchiveWriter() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        GameArchiveHeader h;
+        memset(&h, 0, sizeof(h));
+        at = fwrite(&h, 1, sizeof(h), file);
+        offsets.clear();
+        return at == sizeof(h);
+    }
+
+    // Games longer than 65535 plies, or starting from a position
+    // packPosition() cannot hold, are rejected and nothing is written.
+    bool add(const Position& start, const std::vector<Move>& moves, GameResult result) {
+        if (!file || moves.size() > 0xFFFF) return false;
+        Position initial;
+        initial.setStartPosition();
+        bool custom = start.key != initial.key || start.fullmoveNumber != 1 || start.halfmoveClock != 0;
+        PackedPosition pp;
+        if (custom && !packPosition(start, pp)) return false;
+        uint8_t head[4] = { uint8_t(moves.size() & 0xFF), uint8_t(moves.size() >> 8), result,
+            uint8_t(custom ? RECORD_HAS_START : 0) };
+        offsets.push_back(at);
+        at += fwrite(head, 1, sizeof(head), file);
+        if (custom) at += fwrite(&pp, 1, sizeof(pp), file);
+        if (!moves.empty()) at += fwrite(moves.data(), sizeof(Move), moves.size(), file) * sizeof(Move);
+        return !ferror(file);
+    }
+
+    uint64_t count() const { return offsets.size(); }
+
+    // Writes the index and the final header.
+    bool close() {
+        if (!file) return true;
+        GameArchiveHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, GameArchiveMagic, sizeof(h.magic));
+        h.version = GameArchiveVersion;
+        h.gameCount = offsets.size();
+        h.indexOffset = at;
+        if (!offsets.empty()) fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file);
+        fseek(file, 0, SEEK_SET);
+        fwrite(&h, 1, sizeof(h), file);
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    FILE* file;
+    uint64_t at;
+    std::vector<uint64_t> offsets;  // 8 bytes per game until close()
+};
+
+// One game, read in place: `moves` points into the mapped file.
+struct GameView {
+    GameResult result;
+    bool hasStart;
+    PackedPosition start;
+    const Move* moves;
+    int plies;
+
+    // False if the stored start position is corrupt; the moves cannot be
+    // replayed then.
+    bool startPosition(Position& pos) const {
+        if (hasStart) return unpackPosition(start, pos);
+        pos.setStartPosition();
+        return true;
+    }
+};
+
+class GameArchive {
+public:
+    GameArchive() : count(0), index(0) {}
+
+    bool open(const std::string& path) {
+        count = 0;
+        if (!file.open(path)) return false;
+        GameArchiveHeader h;
+        if (file.size() < sizeof(h)) return false;
+        memcpy(&h, file.data(), sizeof(h));
+        if (memcmp(h.magic, GameArchiveMagic, sizeof(h.magic)) != 0 || h.version != GameArchiveVersion) return false;
+        if (h.indexOffset > file.size() || (file.size() - h.indexOffset) / sizeof(uint64_t) < h.gameCount) return false;
+        count = h.gameCount;
+        index = h.indexOffset;
+        return true;
+    }
+
+    uint64_t size() const { return count; }
+    uint64_t bytes() const { return file.size(); }
+
+    // Game n (0-based) in constant time. False if n is out of range or the
+    // record runs past the end of the file.
+    bool game(uint64_t n, GameView& out) const {
+        if (n >= count) return false;
+        uint64_t offset;
+        memcpy(&offset, file.data() + index + n * sizeof(uint64_t), sizeof(offset));
+        if (offset + 4 > index) return false;
+        const uint8_t* rec = (const uint8_t*)file.data() + offset;
+        out.plies = rec[0] | (rec[1] << 8);
+        out.result = GameResult(rec[2] & 3);
+        out.hasStart = (rec[3] & RECORD_HAS_START) != 0;
+        uint64_t movesAt = offset + 4 + (out.hasStart ? sizeof(PackedPosition) : 0);
+        if (movesAt + out.plies * sizeof(Move) > index) return false;
+        if (out.hasStart) memcpy(&out.start, rec + 4, sizeof(PackedPosition));
+        out.moves = (const Move*)(file.data() + movesAt);   // records keep moves 2-byte aligned
+        return true;
+    }
+
+private:
+    MappedFile file;
+    uint64_t count;
+    uint64_t index;
+};
+
+// ======================= Position Archive =======================
+// Training data: a 32-byte header ("CHSPOSNS", version, count) followed by
+// fixed-size PackedPosition records, so record N sits at 32 + 32 * N.
+const char PositionArchiveMagic[8] = { 'C', 'H', 'S', 'P', 'O', 'S', 'N', 'S' };
+
+class PositionArchiveWriter {
+public:
+    PositionArchiveWriter() : file(nullptr), written(0) {}
+    ~PositionArchiveWriter() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        GameArchiveHeader h;
+        memset(&h, 0, sizeof(h));
+        written = 0;
+        return fwrite(&h, 1, sizeof(h), file) == sizeof(h);
+    }
+
+    bool add(const PackedPosition& pp) {
+        if (!file) return false;
+        written++;
+        return fwrite(&pp, sizeof(pp), 1, file) == 1;
+    }
+
+    uint64_t count() const { return written; }
+
+    bool close() {
+        if (!file) return true;
+        GameArchiveHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, PositionArchiveMagic, sizeof(h.magic));
+        h.version = GameArchiveVersion;
+        h.gameCount = written;
+        fseek(file, 0, SEEK_SET);
+        fwrite(&h, 1, sizeof(h), file);
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    FILE* file;
+    uint64_t written;
+};
+
+class PositionArchive {
+public:
+    PositionArchive() : count(0) {}
+
+    bool open(const std::string& path) {
+        count = 0;
+        if (!file.open(path)) return false;
+        GameArchiveHeader h;
+        if (file.size() < sizeof(h)) return false;
+        memcpy(&h, file.data(), sizeof(h));
+        if (memcmp(h.magic, PositionArchiveMagic, sizeof(h.magic)) != 0 || h.version != GameArchiveVersion) return false;
+        if ((file.size() - sizeof(h)) / sizeof(PackedPosition) < h.gameCount) return false;
+        count = h.gameCount;
+        return true;
+    }
+
+    uint64_t size() const { return count; }
+
+    const PackedPosition& at(uint64_t n) const {
+        return ((const PackedPosition*)(file.data() + sizeof(GameArchiveHeader)))[n];
+    }
+
+private:
+    MappedFile file;
+    uint64_t count;
+};
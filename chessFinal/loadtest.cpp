@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "movegen.h"
+using namespace std;
+
+// ======================= Load Test =======================
+// Plays many games at once against "chessFinal serve": every session
+// alternates a random legal move of its own with a "go" for the server's
+// reply, and starts a new game when one ends. Each request's round trip
+// is timed; at the end come moves per second and latency percentiles.
+// The server's moves are checked for legality against a local copy of
+// every game.
+typedef chrono::steady_clock Clock;
+
+struct Options {
+    string socketPath;          // connect here, or
+    string command;             // run this ("chessFinal serve ...") and talk over its stdin/stdout
+    int connections;
+    int sessions;
+    int depth;
+    double seconds;
+
+    Options() : connections(4), sessions(1000), depth(1), seconds(10) {}
+};
+
+enum SessionState { WAIT_NEW, WAIT_MOVED, WAIT_BESTMOVE, WAIT_CLOSED, RETRY_GO, DONE };
+
+struct Session {
+    int connection;
+    uint64_t id;
+    Position pos;
+    SessionState state;
+    Clock::time_point sentAt;   // a "go" answered busy keeps its first send time
+    Clock::time_point retryAt;
+    int backoffMs;              // wait before the next retry, doubled on every busy
+};
+
+struct Connection {
+    int in, out;
+    string input, output;
+    vector<int> awaitingNew;    // sessions whose "new" is unanswered, oldest first
+    size_t newHead;
+};
+
+struct Latencies {
+    vector<uint32_t> us;
+
+    void add(Clock::time_point sent) {
+        us.push_back((uint32_t)chrono::duration_cast<chrono::microseconds>(Clock::now() - sent).count());
+    }
+
+    uint32_t percentile(double p) {
+        if (us.empty()) return 0;
+        size_t k = min(us.size() - 1, (size_t)(p / 100 * us.size()));
+        nth_element(us.begin(), us.begin() + k, us.end());
+        return us[k];
+    }
+};
+
+class LoadTest {
+public:
+    uint64_t playerMoves, engineMoves, games, busy, refused, errors;
+    Latencies moveLatency, goLatency;
+
+    explicit LoadTest(const Options& opt)
+        : playerMoves(0), engineMoves(0), games(0), busy(0), refused(0), errors(0), opt(opt), active(0), stopping(false),
+          seed(0x9E3779B97F4A7C15ULL), child(-1) {}
+
+    ~LoadTest() {
+        for (Connection& c : conns) {
+            if (c.in >= 0) close(c.in);
+            if (c.out >= 0 && c.out != c.in) close(c.out);
+        }
+        if (child > 0) waitpid(child, nullptr, 0);
+    }
+
+    bool connect() {
+        signal(SIGPIPE, SIG_IGN);
+        if (!opt.command.empty()) return spawn();
+        for (int i = 0;i < opt.connections;i++) {
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, opt.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+                cerr << opt.socketPath << ": " << strerror(errno) << "\n";
+                if (fd >= 0) close(fd);
+                return false;
+            }
+            addConnection(fd, fd);
+        }
+        return true;
+    }
+
+    // Plays until the time is up and every session is closed; returns
+    // the elapsed seconds.
+    double run() {
+        sessions.resize(opt.sessions);
+        active = opt.sessions;
+        for (int i = 0;i < opt.sessions;i++) {
+            sessions[i].connection = i % (int)conns.size();
+            startGame(i);
+        }
+        Clock::time_point start = Clock::now(), stopAt = start + chrono::microseconds((int64_t)(opt.seconds * 1e6));
+        vector<pollfd> fds;
+        char buffer[65536];
+        while (active > 0) {
+            Clock::time_point now = Clock::now();
+            stopping = now >= stopAt;
+            // Sessions told the server is busy ask again after their backoff
+            int timeoutMs = 100;
+            size_t kept = 0;
+            for (int s : retries) {
+                if (sessions[s].state != RETRY_GO) continue;
+                if (stopping) finish(s);
+                else if (now >= sessions[s].retryAt) sendGo(s, true);
+                else {
+                    retries[kept++] = s;
+                    timeoutMs = min(timeoutMs, 1 + (int)chrono::duration_cast<chrono::milliseconds>(sessions[s].retryAt - now).count());
+                }
+            }
+            retries.resize(kept);
+            for (Connection& c : conns) flush(c);
+
+            // Two entries per connection: its input, and its output while
+            // that is a separate pipe with something left to write
+            fds.clear();
+            for (Connection& c : conns) {
+                bool waiting = !c.output.empty();
+                fds.push_back({ c.in, short(POLLIN | (waiting && c.out == c.in ? POLLOUT : 0)), 0 });
+                fds.push_back({ waiting && c.out != c.in ? c.out : -1, POLLOUT, 0 });
+            }
+            if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) break;
+            for (size_t k = 0;k < conns.size();k++) {
+                Connection& c = conns[k];
+                if (!(fds[2 * k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                ssize_t n = read(c.in, buffer, sizeof(buffer));
+                if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                if (n <= 0) {
+                    cerr << "server closed the connection\n";
+                    errors++;
+                    return secondsSince(start);
+                }
+                c.input.append(buffer, (size_t)n);
+                size_t at = 0, end;
+                while ((end = c.input.find('\n', at)) != string::npos) {
+                    handleReply(c, string_view(c.input.data() + at, end - at));
+                    at = end + 1;
+                }
+                c.input.erase(0, at);
+            }
+        }
+        return secondsSince(start);
+    }
+
+    void shutdown() {
+        for (Connection& c : conns) {
+            c.output += "quit\n";
+            flush(c);
+        }
+    }
+
+private:
+    Options opt;
+    vector<Connection> conns;
+    vector<Session> sessions;
+    unordered_map<uint64_t, int> byId;
+    vector<int> retries;        // sessions answered "busy"
+    int active;                 // sessions not yet done
+    bool stopping;              // time is up: close games instead of playing on
+    uint64_t seed;
+    pid_t child;
+
+    static double secondsSince(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    uint64_t random() {
+        seed ^= seed >> 12; seed ^= seed << 25; seed ^= seed >> 27;
+        return seed * 2685821657736338717ULL;
+    }
+
+    static void setNonBlocking(int fd) { fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); }
+
+    void addConnection(int in, int out) {
+        setNonBlocking(in);
+        setNonBlocking(out);
+        conns.push_back({ in, out, string(), string(), vector<int>(), 0 });
+    }
+
+    // The command through the shell, with its stdin and stdout as pipes.
+    bool spawn() {
+        int toServer[2], fromServer[2];
+        if (pipe(toServer) != 0 || pipe(fromServer) != 0) { cerr << "pipe: " << strerror(errno) << "\n"; return false; }
+        child = fork();
+        if (child < 0) { cerr << "fork: " << strerror(errno) << "\n"; return false; }
+        if (child == 0) {
+            dup2(toServer[0], STDIN_FILENO);
+            dup2(fromServer[1], STDOUT_FILENO);
+            close(toServer[0]); close(toServer[1]); close(fromServer[0]); close(fromServer[1]);
+            execl("/bin/sh", "sh", "-c", opt.command.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+        close(toServer[0]);
+        close(fromServer[1]);
+        addConnection(fromServer[0], toServer[1]);
+        return true;
+    }
+
+    void flush(Connection& c) {
+        while (!c.output.empty()) {
+            ssize_t n = write(c.out, c.output.data(), c.output.size());
+            if (n > 0) { c.output.erase(0, (size_t)n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+    }
+
+    void send(int s, const string& line, bool retry = false) {
+        Connection& c = conns[sessions[s].connection];
+        c.output += line;
+        c.output += '\n';
+        if (!retry) sessions[s].sentAt = Clock::now();
+    }
+
+    void startGame(int s) {
+        sessions[s].backoffMs = 1;
+        sessions[s].pos.setStartPosition();
+        sessions[s].state = WAIT_NEW;
+        conns[sessions[s].connection].awaitingNew.push_back(s);
+        send(s, "new");
+    }
+
+    void sendGo(int s, bool retry = false) {
+        sessions[s].state = WAIT_BESTMOVE;
+        send(s, "go " + to_string(sessions[s].id) + " depth " + to_string(opt.depth), retry);
+    }
+
+    void playRandomMove(int s) {
+        MoveList moves;
+        generateLegal(sessions[s].pos, moves);
+        Move m = moves[random() % moves.size()];
+        sessions[s].pos.applyMove(m);
+        sessions[s].state = WAIT_MOVED;
+        send(s, "move " + to_string(sessions[s].id) + " " + moveToUci(m));
+    }
+
+    void finish(int s) {
+        sessions[s].state = WAIT_CLOSED;
+        send(s, "close " + to_string(sessions[s].id));
+    }
+
+    void done(int s) {
+        sessions[s].state = DONE;
+        active--;
+    }
+
+    // Next request for a session after a move: its own move after the
+    // engine's, the engine's after its own, or close once the game is over.
+    void afterMove(int s, string_view status) {
+        if (status != "playing" && status != "check") {
+            games++;
+            finish(s);
+        }
+        else if (stopping) finish(s);
+        else if (sessions[s].state == WAIT_MOVED) sendGo(s);
+        else playRandomMove(s);
+    }
+
+    void handleReply(Connection& c, string_view line) {
+        string_view words[4];
+        int count = 0;
+        for (size_t i = 0;count < 4 && i < line.size();) {
+            size_t j = line.find(' ', i);
+            if (j == string_view::npos) j = line.size();
+            words[count++] = line.substr(i, j - i);
+            i = j + 1;
+        }
+        if (count < 2) { errors++; cerr << "unexpected reply: " << line << "\n"; return; }
+
+        // "new" is answered in order, with the id or an error
+        if (words[0] == "new" || (words[0] == "error" && words[1] == "-")) {
+            if (c.newHead == c.awaitingNew.size()) { errors++; cerr << "unexpected reply: " << line << "\n"; return; }
+            int s = c.awaitingNew[c.newHead++];
+            if (c.newHead == c.awaitingNew.size()) { c.awaitingNew.clear(); c.newHead = 0; }
+            // A full server is back-pressure too: the session sits this run out
+            if (words[0] == "error") {
+                if (line.find("server full") != string_view::npos) refused++;
+                else { errors++; cerr << line << "\n"; }
+                done(s);
+                return;
+            }
+            sessions[s].id = strtoull(string(words[1]).c_str(), nullptr, 10);
+            byId[sessions[s].id] = s;
+            if (stopping) finish(s);
+            else playRandomMove(s);
+            return;
+        }
+        auto it = byId.find(strtoull(string(words[1]).c_str(), nullptr, 10));
+        if (it == byId.end()) { errors++; cerr << "unexpected reply: " << line << "\n"; return; }
+        int s = it->second;
+        Session& session = sessions[s];
+        if (words[0] == "moved" && session.state == WAIT_MOVED) {
+            moveLatency.add(session.sentAt);
+            playerMoves++;
+            afterMove(s, count > 3 ? words[3] : string_view());
+        }
+        else if (words[0] == "bestmove" && session.state == WAIT_BESTMOVE) {
+            goLatency.add(session.sentAt);
+            session.backoffMs = 1;
+            Move m = count > 2 ? moveFromUci(session.pos, string(words[2])) : MOVE_NONE;
+            if (m == MOVE_NONE) {
+                errors++;
+                cerr << "illegal engine move: " << line << "\n";
+                finish(s);
+                return;
+            }
+            session.pos.applyMove(m);
+            engineMoves++;
+            afterMove(s, count > 3 ? words[3] : string_view());
+        }
+        else if (words[0] == "busy" && session.state == WAIT_BESTMOVE) {
+            busy++;
+            session.state = RETRY_GO;
+            session.retryAt = Clock::now() + chrono::milliseconds(session.backoffMs);
+            session.backoffMs = min(2 * session.backoffMs, 32);
+            retries.push_back(s);
+        }
+        else if (words[0] == "closed" && session.state == WAIT_CLOSED) {
+            byId.erase(it);
+            if (stopping) done(s);
+            else startGame(s);
+        }
+        else {
+            errors++;
+            cerr << "unexpected reply: " << line << "\n";
+            if (session.state != WAIT_CLOSED) finish(s);
+        }
+    }
+};
+
+void usage() {
+    cerr << "Usage: loadtest (--socket PATH | --exec \"CMD\") [--connections N] [--sessions N] [--depth D] [--seconds S]\n"
+        << "  --socket PATH   connect to \"chessFinal serve --socket PATH\" with N connections\n"
+        << "  --exec CMD      run CMD (e.g. \"./build/chessFinal serve\") and talk over its stdin/stdout\n";
+}
+
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    Options opt;
+    for (int i = 1;i < argc;i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) opt.socketPath = argv[++i];
+        else if (arg == "--exec" && hasValue) opt.command = argv[++i];
+        else if (arg == "--connections" && hasValue) opt.connections = max(1, atoi(argv[++i]));
+        else if (arg == "--sessions" && hasValue) opt.sessions = max(1, atoi(argv[++i]));
+        else if (arg == "--depth" && hasValue) opt.depth = max(1, atoi(argv[++i]));
+        else if (arg == "--seconds" && hasValue) opt.seconds = atof(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (opt.socketPath.empty() == opt.command.empty()) { usage(); return 2; }
+
+    LoadTest test(opt);
+    if (!test.connect()) return 1;
+    double secs = test.run();
+    test.shutdown();
+
+    uint64_t moves = test.playerMoves + test.engineMoves;
+    cout << opt.sessions << " sessions, depth " << opt.depth << ", " << secs << " s\n"
+        << moves << " moves (" << test.playerMoves << " client, " << test.engineMoves << " engine), "
+        << (secs > 0 ? (uint64_t)(moves / secs) : 0) << " moves/s, " << test.games << " games finished\n"
+        << "move  latency  p50 " << test.moveLatency.percentile(50) << " us  p99 " << test.moveLatency.percentile(99)
+        << " us  max " << test.moveLatency.percentile(100) << " us\n"
+        << "go    latency  p50 " << test.goLatency.percentile(50) << " us  p99 " << test.goLatency.percentile(99)
+        << " us  max " << test.goLatency.percentile(100) << " us\n"
+        << test.busy << " busy replies, " << test.refused << " sessions refused (server full), " << test.errors << " errors\n";
+    return test.errors ? 1 : 0;
+}
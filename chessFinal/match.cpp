@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "smp.h"
+#include "gamefile.h"
+#include "pgn.h"
+using namespace std;
+
+// ======================= Engines and Time Control =======================
+// Both sides are this engine, configured independently, so a match shows
+// what a depth, node budget, hash size or thread count is worth in Elo.
+struct EngineConfig {
+    string name;
+    int depth;          // 0 = unlimited under a clock, depth 4 otherwise
+    uint64_t nodes;     // 0 = no node limit
+    int threads;
+    size_t hashMb;
+    EngineConfig() : depth(0), nodes(0), threads(1), hashMb(16) {}
+};
+
+// "name=new,depth=6,nodes=20000,threads=1,hash=16"; false on an unknown key.
+bool parseEngine(const string& spec, EngineConfig& cfg) {
+    stringstream in(spec);
+    string field;
+    while (getline(in, field, ',')) {
+        size_t eq = field.find('=');
+        if (eq == string::npos) return false;
+        string key = field.substr(0, eq), value = field.substr(eq + 1);
+        if (key == "name") cfg.name = value;
+        else if (key == "depth") cfg.depth = atoi(value.c_str());
+        else if (key == "nodes") cfg.nodes = strtoull(value.c_str(), nullptr, 10);
+        else if (key == "threads") cfg.threads = atoi(value.c_str());
+        else if (key == "hash") cfg.hashMb = (size_t)atoi(value.c_str());
+        else return false;
+    }
+    return true;
+}
+
+// Sudden death plus increment, e.g. "10+0.1" (seconds).
+struct TimeControl {
+    int64_t baseMs, incMs;
+    TimeControl() : baseMs(0), incMs(0) {}
+    bool enabled() const { return baseMs > 0; }
+};
+
+bool parseTimeControl(const string& s, TimeControl& tc) {
+    size_t plus = s.find('+');
+    tc.baseMs = (int64_t)(atof(s.substr(0, plus).c_str()) * 1000);
+    tc.incMs = plus == string::npos ? 0 : (int64_t)(atof(s.substr(plus + 1).c_str()) * 1000);
+    return tc.baseMs > 0 && tc.incMs >= 0;
+}
+
+// One engine instance per worker thread and side: its own searchers,
+// transposition table and pawn tables, never shared with another game.
+struct Engine {
+    EngineConfig cfg;
+    TranspositionTable tt;
+    SmpSearch search;
+
+    explicit Engine(const EngineConfig& c) : cfg(c) {
+        tt.resize(c.hashMb);
+        search.setTable(&tt);
+        search.setThreads(c.threads);
+    }
+};
+
+// ======================= Playing a Game =======================
+enum Termination { CHECKMATE, STALEMATE, REPETITION, FIFTY_MOVES, INSUFFICIENT_MATERIAL, TIME_FORFEIT, TERMINATION_NB };
+const char* TerminationNames[TERMINATION_NB] = {
+    "checkmate", "stalemate", "repetition", "fifty-move rule", "insufficient material", "time forfeit"
+};
+
+struct GameRecord {
+    Position start;
+    vector<Move> moves;
+    GameResult result;
+    Termination termination;
+};
+
+// Earlier occurrences of the current position since the last irreversible
+// move; keys ends with the current position.
+int repetitions(const vector<uint64_t>& keys, int halfmoveClock) {
+    int last = (int)keys.size() - 1, count = 0;
+    for (int i = last - 2;i >= 0 && i >= last - halfmoveClock;i -= 2) {
+        if (keys[i] == keys[last]) count++;
+    }
+    return count;
+}
+
+// Bare kings, or a single minor piece against a bare king.
+bool insufficientMaterial(const Position& pos) {
+    Bitboard heavy = 0;
+    for (Color c : { WHITE, BLACK }) heavy |= pos.pieces(c, PAWN) | pos.pieces(c, ROOK) | pos.pieces(c, QUEEN);
+    return !heavy && popCount(pos.occupied()) <= 3;
+}
+
+void playGame(Engine& white, Engine& black, const Position& start, const TimeControl& tc, GameRecord& game) {
+    Engine* engines[2] = { &white, &black };
+    Position pos = start;
+    vector<uint64_t> keys(1, pos.key);
+    int64_t clock[2] = { tc.baseMs, tc.baseMs };
+    game.start = start;
+    game.moves.clear();
+    white.tt.clear();
+    black.tt.clear();
+
+    for (;;) {
+        Color us = pos.sideToMove;
+        MoveList legal;
+        generateLegal(pos, legal);
+        if (legal.size() == 0) {
+            bool mated = pos.inCheck(us);
+            game.result = !mated ? DRAWN : us == WHITE ? BLACK_WINS : WHITE_WINS;
+            game.termination = mated ? CHECKMATE : STALEMATE;
+            return;
+        }
+        game.result = DRAWN;
+        if (pos.halfmoveClock >= 100) { game.termination = FIFTY_MOVES; return; }
+        if (repetitions(keys, pos.halfmoveClock) >= 2) { game.termination = REPETITION; return; }
+        if (insufficientMaterial(pos)) { game.termination = INSUFFICIENT_MATERIAL; return; }
+
+        Engine& e = *engines[us];
+        SearchLimits limits;
+        limits.depth = e.cfg.depth > 0 ? e.cfg.depth : tc.enabled() || e.cfg.nodes ? MAX_PLY - 1 : 4;
+        limits.nodes = e.cfg.nodes;
+        if (tc.enabled()) limits.movetimeMs = allocateTime(clock[us], tc.incMs);
+        auto begin = chrono::steady_clock::now();
+        SearchInfo info = e.search.think(pos, keys, limits);
+        int64_t spent = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - begin).count();
+        if (tc.enabled()) {
+            clock[us] -= spent;
+            if (clock[us] < 0) {
+                game.result = us == WHITE ? BLACK_WINS : WHITE_WINS;
+                game.termination = TIME_FORFEIT;
+                return;
+            }
+            clock[us] += tc.incMs;
+        }
+
+        Move m = info.bestMove();
+        bool found = false;
+        for (int i = 0;i < legal.count && !found;i++) found = legal[i] == m;
+        if (!found) m = legal[0];       // cannot happen with this engine, but never play an illegal move
+        pos.applyMove(m);
+        keys.push_back(pos.key);
+        game.moves.push_back(m);
+    }
+}
+
+// ======================= Statistics =======================
+// Scores from the first engine's point of view.
+struct MatchStats {
+    int wins, losses, draws;
+    int terminations[TERMINATION_NB];
+    MatchStats() : wins(0), losses(0), draws(0) { for (int& t : terminations) t = 0; }
+
+    int games() const { return wins + losses + draws; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+    // Variance of a single game's score (0, 1/2 or 1).
+    double variance() const {
+        int n = games();
+        if (n == 0) return 0;
+        double mu = score();
+        return (wins * (1 - mu) * (1 - mu) + draws * (0.5 - mu) * (0.5 - mu) + losses * mu * mu) / n;
+    }
+};
+
+// Logistic model: a score s is worth 400 log10(s / (1 - s)) Elo. Scores of
+// exactly 0 or 1 are pulled in slightly so the estimate stays finite.
+double eloFromScore(double s) {
+    if (s < 0.001) s = 0.001;
+    if (s > 0.999) s = 0.999;
+    return 400.0 * log10(s / (1.0 - s));
+}
+
+double scoreFromElo(double elo) { return 1.0 / (1.0 + pow(10.0, -elo / 400.0)); }
+
+// Elo difference and the half-width of its 95% confidence interval.
+void eloEstimate(const MatchStats& st, double& elo, double& margin) {
+    double mu = st.score();
+    double se = st.games() ? sqrt(st.variance() / st.games()) : 0;
+    elo = eloFromScore(mu);
+    margin = (eloFromScore(mu + 1.96 * se) - eloFromScore(mu - 1.96 * se)) / 2;
+}
+
+// Sequential probability ratio test of H0: elo = elo0 against H1: elo =
+// elo1, with the game scores approximated as normal. The match can stop as
+// soon as the log-likelihood ratio leaves (lowerBound, upperBound).
+struct Sprt {
+    double elo0, elo1, alpha, beta;
+    bool enabled;
+    Sprt() : elo0(0), elo1(5), alpha(0.05), beta(0.05), enabled(false) {}
+
+    double lowerBound() const { return log(beta / (1 - alpha)); }
+    double upperBound() const { return log((1 - beta) / alpha); }
+
+    double llr(const MatchStats& st) const {
+        double var = st.variance();
+        if (var <= 0) return 0;
+        double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+        return st.games() * (s1 - s0) * (2 * st.score() - s0 - s1) / (2 * var);
+    }
+
+    // -1: H0 accepted, 1: H1 accepted, 0: keep playing.
+    int decision(const MatchStats& st) const {
+        double l = llr(st);
+        return l <= lowerBound() ? -1 : l >= upperBound() ? 1 : 0;
+    }
+};
+
+void printStatus(const MatchStats& st, const Sprt& sprt, int total) {
+    double elo, margin;
+    eloEstimate(st, elo, margin);
+    cout << "Games " << st.games() << "/" << total << ": +" << st.wins << " -" << st.losses << " =" << st.draws
+        << "  score " << st.score() << "  Elo " << elo << " +/- " << margin;
+    if (sprt.enabled) cout << "  LLR " << sprt.llr(st) << " (" << sprt.lowerBound() << ", " << sprt.upperBound() << ")";
+    cout << endl;
+}
+
+// ======================= Match Runner =======================
+struct MatchOptions {
+    EngineConfig engines[2];
+    TimeControl tc;
+    int games;
+    int concurrency;
+    vector<Position> book;
+    int randomPlies;    // random legal plies played out from each opening
+    uint64_t seed;
+    string pgnPath;
+    Sprt sprt;
+};
+
+// The opening of pair `pair`: its book position followed by randomPlies
+// random legal moves chosen from (seed, pair), so both games of a pair
+// start alike and a rerun with the same seed replays the same openings.
+// Stops early rather than walk into a position with no legal moves.
+Position pairOpening(const MatchOptions& opt, int pair) {
+    Position pos = opt.book[pair % opt.book.size()];
+    uint64_t s = (opt.seed ^ (uint64_t(pair) + 1) * 0x9E3779B97F4A7C15ULL) | 1;    // xorshift64*
+    auto next = [&s]() {
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    };
+    for (int ply = 0;ply < opt.randomPlies;ply++) {
+        MoveList legal;
+        generateLegal(pos, legal);
+        if (legal.size() == 0) break;
+        Position child = pos;
+        child.applyMove(legal[int(next() % legal.size())]);
+        if (!hasLegalMoves(child)) break;
+        pos = child;
+    }
+    return pos;
+}
+
+// Workers take game numbers from a shared counter. Games come in pairs on
+// the same opening with colours reversed, so a lopsided opening cancels
+// out. Results, PGN output and the SPRT check happen under one lock.
+int runMatch(const MatchOptions& opt) {
+    atomic<int> nextGame(0);
+    atomic<bool> finished(false);
+    mutex lock;
+    MatchStats stats;
+    ofstream pgn;
+    if (!opt.pgnPath.empty()) {
+        pgn.open(opt.pgnPath);
+        if (!pgn) { cerr << "Cannot create " << opt.pgnPath << "\n"; return 1; }
+    }
+    int reportEvery = opt.games >= 20 ? opt.games / 20 : 1;
+
+    auto worker = [&]() {
+        Engine first(opt.engines[0]), second(opt.engines[1]);
+        GameRecord game;
+        for (;;) {
+            int n = nextGame++;
+            if (n >= opt.games || finished) break;
+            Position start = pairOpening(opt, n / 2);
+            bool firstIsWhite = (n & 1) == 0;
+            if (firstIsWhite) playGame(first, second, start, opt.tc, game);
+            else playGame(second, first, start, opt.tc, game);
+
+            lock_guard<mutex> guard(lock);
+            if (finished) break;
+            if (game.result == DRAWN) stats.draws++;
+            else if ((game.result == WHITE_WINS) == firstIsWhite) stats.wins++;
+            else stats.losses++;
+            stats.terminations[game.termination]++;
+            if (pgn.is_open()) {
+                const string& w = opt.engines[firstIsWhite ? 0 : 1].name;
+                const string& b = opt.engines[firstIsWhite ? 1 : 0].name;
+                PgnTagList tags = { { "Event", "match" }, { "Site", "?" }, { "Date", "????.??.??" },
+                    { "Round", to_string(n + 1) }, { "White", w }, { "Black", b },
+                    { "Result", resultString(game.result) }, { "Termination", TerminationNames[game.termination] } };
+                writePgn(pgn, tags, game.start, game.moves, resultString(game.result));
+            }
+            if (stats.games() % reportEvery == 0) printStatus(stats, opt.sprt, opt.games);
+            if (opt.sprt.enabled && opt.sprt.decision(stats) != 0) finished = true;
+        }
+    };
+
+    auto begin = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int i = 0;i < opt.concurrency;i++) pool.emplace_back(worker);
+    for (thread& t : pool) t.join();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    double elo, margin;
+    eloEstimate(stats, elo, margin);
+    cout << "\nScore of " << opt.engines[0].name << " vs " << opt.engines[1].name << ": "
+        << stats.wins << " - " << stats.losses << " - " << stats.draws << "  [" << stats.score() << "]  "
+        << stats.games() << " games in " << secs << " s\n";
+    cout << "Elo difference: " << elo << " +/- " << margin << " (95%)\n";
+    if (opt.sprt.enabled) {
+        int d = opt.sprt.decision(stats);
+        cout << "SPRT elo0=" << opt.sprt.elo0 << " elo1=" << opt.sprt.elo1 << ": LLR " << opt.sprt.llr(stats)
+            << " (" << opt.sprt.lowerBound() << ", " << opt.sprt.upperBound() << ")  "
+            << (d < 0 ? "H0 accepted" : d > 0 ? "H1 accepted" : "inconclusive") << "\n";
+    }
+    cout << "Terminations:";
+    for (int t = 0;t < TERMINATION_NB;t++) if (stats.terminations[t]) cout << "  " << TerminationNames[t] << " " << stats.terminations[t];
+    cout << "\n";
+    return 0;
+}
+
+// One FEN or EPD position per line; blank lines and '#' comments skipped.
+bool loadBook(const string& path, vector<Position>& book) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        Position pos;
+        if (pos.setFen(line)) book.push_back(pos);
+        else cerr << path << ":" << lineNo << ": invalid position skipped\n";
+    }
+    return true;
+}
+
+void usage() {
+    cerr << "Usage: match [options]\n"
+        << "  --engine name=N,depth=D,nodes=N,threads=T,hash=MB   first use sets engine 1, second engine 2\n"
+        << "  --tc base+inc       time control in seconds, e.g. 10+0.1 (default: depth/nodes only)\n"
+        << "  --games N           games to play, in colour-reversed pairs (default 100)\n"
+        << "  --concurrency N     games played at once (default: hardware threads)\n"
+        << "  --book file         FEN/EPD openings, one per line (default: initial position)\n"
+        << "  --random-plies N    random legal plies after each opening (default: 4 when needed, see below)\n"
+        << "  --seed S            seed for the random plies (default 1)\n"
+        << "  --pgn file          write every game\n"
+        << "  --sprt elo0 elo1    stop once H0 or H1 is accepted\n"
+        << "  --alpha A --beta B  SPRT error rates (default 0.05)\n"
+        << "Without --tc, single-threaded play is deterministic: a pair replayed on the same\n"
+        << "opening repeats the same two games. Unless there are games/2 distinct openings,\n"
+        << "random plies are added so that every pair gets its own.\n";
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+
+    MatchOptions opt;
+    opt.engines[0].name = "engine1";
+    opt.engines[1].name = "engine2";
+    opt.games = 100;
+    opt.concurrency = (int)thread::hardware_concurrency();
+    opt.randomPlies = -1;
+    opt.seed = 1;
+    int enginesGiven = 0;
+    string bookPath;
+    for (int i = 1;i < argc;i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine" && hasValue && enginesGiven < 2) {
+            if (!parseEngine(argv[++i], opt.engines[enginesGiven++])) { usage(); return 2; }
+        }
+        else if (arg == "--tc" && hasValue) {
+            if (!parseTimeControl(argv[++i], opt.tc)) { usage(); return 2; }
+        }
+        else if (arg == "--games" && hasValue) opt.games = atoi(argv[++i]);
+        else if (arg == "--concurrency" && hasValue) opt.concurrency = atoi(argv[++i]);
+        else if (arg == "--book" && hasValue) bookPath = argv[++i];
+        else if (arg == "--random-plies" && hasValue) opt.randomPlies = max(0, atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) opt.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--pgn" && hasValue) opt.pgnPath = argv[++i];
+        else if (arg == "--sprt" && i + 2 < argc) {
+            opt.sprt.enabled = true;
+            opt.sprt.elo0 = atof(argv[++i]);
+            opt.sprt.elo1 = atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && hasValue) opt.sprt.alpha = atof(argv[++i]);
+        else if (arg == "--beta" && hasValue) opt.sprt.beta = atof(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (opt.games < 1) opt.games = 1;
+    if (opt.concurrency < 1) opt.concurrency = 1;
+    if (opt.concurrency > opt.games) opt.concurrency = opt.games;
+
+    if (!bookPath.empty()) {
+        if (!loadBook(bookPath, opt.book)) { cerr << "Cannot open " << bookPath << "\n"; return 1; }
+        if (opt.book.empty()) { cerr << bookPath << ": no valid positions\n"; return 1; }
+    }
+    else {
+        opt.book.emplace_back();
+        opt.book.back().setStartPosition();
+    }
+
+    // Repeated games are not independent samples: they would shrink the Elo
+    // interval and push the SPRT towards a decision the data do not support.
+    bool repeats = !opt.tc.enabled() && (int)opt.book.size() < opt.games / 2;
+    if (opt.randomPlies < 0) opt.randomPlies = repeats ? 4 : 0;
+    if (repeats && opt.randomPlies == 0) {
+        cerr << "Warning: " << opt.book.size() << " openings for " << opt.games
+            << " games without a clock; pairs on the same opening repeat the same games\n";
+        if (opt.sprt.enabled) { cerr << "Refusing --sprt on repeated games; use --random-plies or a larger --book\n"; return 2; }
+    }
+
+    cout << opt.engines[0].name << " vs " << opt.engines[1].name << ", " << opt.games << " games, "
+        << opt.concurrency << " at a time, " << opt.book.size() << " openings";
+    if (opt.randomPlies > 0) cout << " + " << opt.randomPlies << " random plies (seed " << opt.seed << ")";
+    cout << "\n";
+    return runMatch(opt);
+}
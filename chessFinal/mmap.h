@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ======================= Memory-Mapped File =======================
+// Read-only view of a whole file. The OS pages data in on demand, so
+// multi-GB inputs cost address space rather than heap, and parsers can
+// hand out string_views into the mapping instead of copying.
+class MappedFile {
+public:
+    MappedFile() : ptr(nullptr), len(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // sequential hints the OS to read ahead aggressively.
+    bool open(const std::string& path, bool sequential = false) {
+        close();
+#if defined(_WIN32)
+        (void)sequential;
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return false; }
+        len = (size_t)size.QuadPart;
+        if (len > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+        if (len > 0 && !ptr) { len = 0; return false; }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        len = (size_t)st.st_size;
+        if (len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            ptr = p == MAP_FAILED ? nullptr : (const char*)p;
+            if (ptr && sequential) madvise((void*)ptr, len, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        if (len > 0 && !ptr) { len = 0; return false; }
+#endif
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        if (ptr) UnmapViewOfFile(ptr);
+#else
+        if (ptr) munmap((void*)ptr, len);
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    std::string_view view() const { return std::string_view(ptr, len); }
+
+private:
+    const char* ptr;
+    size_t len;
+};
@@ -0,0 +1,271 @@
+#pragma once
+#include <string>
+#include "position.h"
+
+// ======================= Move List =======================
+// Fixed-capacity list that lives on the stack; no position has more
+// than 218 legal moves.
+const int MAX_MOVES = 256;
+
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count;
+
+    MoveList() : count(0) {}
+    void add(Move m) { moves[count++] = m; }
+    int size() const { return count; }
+    Move operator[](int i) const { return moves[i]; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
+
+// Long algebraic form used by tools and engine protocols: e2e4, e7e8q.
+inline std::string moveToUci(Move m) {
+    std::string s = squareName(moveFrom(m)) + squareName(moveTo(m));
+    if (isPromotion(m)) s += "nbrq"[promotionType(m) - KNIGHT];
+    return s;
+}
+
+// ======================= Legality =======================
+// King square, checking pieces and pinned pieces for the side to move,
+// shared by every move's legality test. The position keeps checkers and
+// pins up to date as moves are made, so this is a few loads.
+struct CheckInfo {
+    int kingSq;
+    Bitboard checkers;
+    Bitboard pinned;
+    Bitboard checkMask;  // non-king moves must land here while in check
+};
+
+inline CheckInfo computeCheckInfo(const Position& pos) {
+    CheckInfo ci;
+    ci.kingSq = pos.kingSquare(pos.sideToMove);
+    ci.checkers = pos.checkers;
+    ci.pinned = pos.pinned;
+    ci.checkMask = ci.checkers ? BetweenBB[ci.kingSq][lsb(ci.checkers)] | ci.checkers : ~0ULL;
+    return ci;
+}
+
+inline bool isLegal(const Position& pos, Move m, const CheckInfo& ci) {
+    STATS_SCOPE(STAT_IS_LEGAL);
+    if (ci.kingSq == NO_SQUARE) return true;
+    int from = moveFrom(m), to = moveTo(m);
+    Color them = !pos.sideToMove;
+
+    if (from == ci.kingSq)
+        return !(pos.attackersTo(to, pos.occupied() ^ squareBB(from)) & pos.pieces(them));
+    if (moreThanOne(ci.checkers)) return false;
+
+    // En passant removes two pawns from the same row, so re-test the king
+    // against the resulting occupancy.
+    if (moveFlag(m) == EP_CAPTURE) {
+        int capSq = Position::epCaptureSquare(to, pos.sideToMove);
+        Bitboard occ = (pos.occupied() ^ squareBB(from) ^ squareBB(capSq)) | squareBB(to);
+        return !(pos.attackersTo(ci.kingSq, occ) & pos.pieces(them) & ~squareBB(capSq));
+    }
+    if (!(squareBB(to) & ci.checkMask)) return false;
+    return !(ci.pinned & squareBB(from)) || (LineBB[ci.kingSq][from] & squareBB(to));
+}
+
+// ======================= Legal Generation =======================
+// One enumerator, specialised at compile time on the side to move and on
+// what to generate, so pawn directions, promotion ranks and castling paths
+// are constants rather than branches on the colour:
+//   GEN_CAPTURES  captures, en passant and every promotion
+//   GEN_QUIETS    everything else, castling included
+//   GEN_ALL       both
+//   GEN_EVASIONS  all moves, for a side in check (no castling)
+// Moves land inside the check mask by construction, so only king moves,
+// pinned pieces and en passant go through isLegal().
+enum GenType { GEN_CAPTURES, GEN_QUIETS, GEN_ALL, GEN_EVASIONS };
+
+// Castling needs the rights, an empty path and a king that is neither in
+// check nor passing through an attacked square; the landing square is
+// checked like any other king move.
+struct CastlingPath {
+    int right;
+    int kingFrom, kingTo;
+    int crossed;            // square the king passes over
+    Bitboard empty;         // squares between king and rook
+    MoveFlag flag;
+};
+
+inline constexpr CastlingPath CastlingPaths[2][2] = {
+    { { WHITE_OO, 60, 62, 61, squareBB(61) | squareBB(62), KING_CASTLE },
+      { WHITE_OOO, 60, 58, 59, squareBB(57) | squareBB(58) | squareBB(59), QUEEN_CASTLE } },
+    { { BLACK_OO, 4, 6, 5, squareBB(5) | squareBB(6), KING_CASTLE },
+      { BLACK_OOO, 4, 2, 3, squareBB(1) | squareBB(2) | squareBB(3), QUEEN_CASTLE } },
+};
+
+// Pawns advance towards row 0 for White (square - 8) and row 7 for Black.
+template<Color Us> struct PawnDirection {
+    static constexpr int Up = Us == WHITE ? -8 : 8;
+    static constexpr Bitboard PromotionRank = Us == WHITE ? Rank8BB : Rank1BB;
+    static constexpr Bitboard ThirdRank = Us == WHITE ? Rank1BB >> 16 : Rank8BB << 16;   // where a double push passes
+    static constexpr Bitboard shift(Bitboard b) { return Us == WHITE ? b >> 8 : b << 8; }
+};
+
+inline void addPromotions(MoveList& list, int from, int to, bool capture) {
+    int base = capture ? PROMOTION_CAPTURE : PROMOTION;
+    for (int t = QUEEN;t >= KNIGHT;t--) list.add(encodeMove(from, to, base + (t - KNIGHT)));
+}
+
+// mask: squares a non-king move may land on (the check mask when in check).
+template<Color Us, GenType Type>
+void generatePawnMoves(const Position& pos, MoveList& list, Bitboard mask) {
+    typedef PawnDirection<Us> Dir;
+    constexpr bool captures = Type != GEN_QUIETS, quiets = Type != GEN_CAPTURES;
+    Bitboard pawns = pos.pieces(Us, PAWN);
+    Bitboard empty = ~pos.occupied();
+    Bitboard enemies = pos.pieces(!Us) & mask;
+
+    Bitboard single = Dir::shift(pawns) & empty;
+    if (quiets) {
+        for (Bitboard b = single & mask & ~Dir::PromotionRank;b;) {
+            int to = popLsb(b);
+            list.add(encodeMove(to - Dir::Up, to, QUIET));
+        }
+        for (Bitboard b = Dir::shift(single & Dir::ThirdRank) & empty & mask;b;) {
+            int to = popLsb(b);
+            list.add(encodeMove(to - 2 * Dir::Up, to, DOUBLE_PUSH));
+        }
+    }
+    if (captures) {
+        for (Bitboard b = single & mask & Dir::PromotionRank;b;) {
+            int to = popLsb(b);
+            addPromotions(list, to - Dir::Up, to, false);
+        }
+        for (Bitboard b = pawns;b;) {
+            int from = popLsb(b);
+            Bitboard attacks = pawnAttacks(Us, from);
+            for (Bitboard caps = attacks & enemies;caps;) {
+                int to = popLsb(caps);
+                if (squareBB(to) & Dir::PromotionRank) addPromotions(list, from, to, true);
+                else list.add(encodeMove(from, to, CAPTURE));
+            }
+            // isLegal() decides en passant, check evasion included
+            if (pos.epSquare != NO_SQUARE && (attacks & squareBB(pos.epSquare)))
+                list.add(encodeMove(from, pos.epSquare, EP_CAPTURE));
+        }
+    }
+}
+
+template<Color Us, PieceType Pt>
+void generatePieceMoves(const Position& pos, MoveList& list, Bitboard targets) {
+    Bitboard occ = pos.occupied();
+    Bitboard enemies = pos.pieces(!Us);
+    for (Bitboard b = pos.pieces(Us, Pt);b;) {
+        int from = popLsb(b);
+        for (Bitboard t = attacksFrom(Pt, Us, from, occ) & targets;t;) {
+            int to = popLsb(t);
+            list.add(encodeMove(from, to, (enemies & squareBB(to)) ? CAPTURE : QUIET));
+        }
+    }
+}
+
+template<Color Us>
+void generateCastling(const Position& pos, MoveList& list) {
+    Bitboard occ = pos.occupied();
+    for (const CastlingPath& c : CastlingPaths[Us]) {
+        if ((pos.castling & c.right) && !(occ & c.empty) && !pos.isAttacked(c.crossed, !Us))
+            list.add(encodeMove(c.kingFrom, c.kingTo, c.flag));
+    }
+}
+
+// Legal moves of kind Type for Us, who must be the side to move.
+template<Color Us, GenType Type>
+void generateMoves(const Position& pos, const CheckInfo& ci, MoveList& list) {
+    int first = list.count;
+    Bitboard own = pos.pieces(Us), enemies = pos.pieces(!Us), empty = ~pos.occupied();
+    Bitboard kinds = Type == GEN_CAPTURES ? enemies : Type == GEN_QUIETS ? empty : ~own;
+
+    // Against a double check only the king can move
+    if (!moreThanOne(ci.checkers)) {
+        Bitboard targets = kinds & ci.checkMask;
+        generatePawnMoves<Us, Type>(pos, list, ci.checkMask);
+        generatePieceMoves<Us, KNIGHT>(pos, list, targets);
+        generatePieceMoves<Us, BISHOP>(pos, list, targets);
+        generatePieceMoves<Us, ROOK>(pos, list, targets);
+        generatePieceMoves<Us, QUEEN>(pos, list, targets);
+    }
+    if (ci.kingSq != NO_SQUARE) {
+        for (Bitboard t = kingAttacks(ci.kingSq) & kinds;t;) {
+            int to = popLsb(t);
+            list.add(encodeMove(ci.kingSq, to, (enemies & squareBB(to)) ? CAPTURE : QUIET));
+        }
+        if ((Type == GEN_ALL || Type == GEN_QUIETS) && !ci.checkers && (pos.castling & (Us == WHITE ? 3 : 12)))
+            generateCastling<Us>(pos, list);
+    }
+
+    Bitboard verify = ci.pinned | (ci.kingSq != NO_SQUARE ? squareBB(ci.kingSq) : 0);
+    int kept = first;
+    for (int i = first;i < list.count;i++) {
+        Move m = list.moves[i];
+        if (((verify & squareBB(moveFrom(m))) || moveFlag(m) == EP_CAPTURE) && !isLegal(pos, m, ci)) continue;
+        list.moves[kept++] = m;
+    }
+    list.count = kept;
+}
+
+template<GenType Type>
+void generate(const Position& pos, const CheckInfo& ci, MoveList& list) {
+    STATS_SCOPE(STAT_MOVEGEN);
+    if (pos.sideToMove == WHITE) generateMoves<WHITE, Type>(pos, ci, list);
+    else generateMoves<BLACK, Type>(pos, ci, list);
+}
+
+inline void generateLegal(const Position& pos, MoveList& list) {
+    CheckInfo ci = computeCheckInfo(pos);
+    if (ci.checkers) generate<GEN_EVASIONS>(pos, ci, list);
+    else generate<GEN_ALL>(pos, ci, list);
+}
+
+// Legal captures, en passant and promotions only: quiescence search and
+// analysis tools that only care about material changing hands.
+inline void generateCaptures(const Position& pos, MoveList& list) {
+    generate<GEN_CAPTURES>(pos, computeCheckInfo(pos), list);
+}
+
+// The legal moves generateCaptures() leaves out.
+inline void generateQuiets(const Position& pos, MoveList& list) {
+    generate<GEN_QUIETS>(pos, computeCheckInfo(pos), list);
+}
+
+// Mate and stalemate detection. Most positions let the king step
+// somewhere, which settles it without building a move list; otherwise
+// (and always against a double check, where only the king may move) the
+// answer comes from the legal moves, in check only evasions.
+inline bool hasLegalMoves(const Position& pos) {
+    int k = pos.kingSquare(pos.sideToMove);
+    if (k != NO_SQUARE) {
+        Bitboard occ = pos.occupied() ^ squareBB(k), them = pos.pieces(!pos.sideToMove);
+        for (Bitboard t = kingAttacks(k) & ~pos.pieces(pos.sideToMove);t;) {
+            if (!(pos.attackersTo(popLsb(t), occ) & them)) return true;
+        }
+        if (moreThanOne(pos.checkers)) return false;
+    }
+    MoveList list;
+    generateLegal(pos, list);
+    return list.size() > 0;
+}
+
+// Whether m is one of the legal moves; guards replaying moves read from
+// files, since makeMove() trusts its input.
+inline bool isLegalMove(const Position& pos, Move m) {
+    MoveList list;
+    generateLegal(pos, list);
+    for (int i = 0;i < list.count;i++) {
+        if (list.moves[i] == m) return true;
+    }
+    return false;
+}
+
+// The legal move written as "e2e4" / "e7e8q", or MOVE_NONE.
+inline Move moveFromUci(const Position& pos, const std::string& s) {
+    MoveList list;
+    generateLegal(pos, list);
+    for (int i = 0;i < list.count;i++) {
+        if (moveToUci(list.moves[i]) == s) return list.moves[i];
+    }
+    return MOVE_NONE;
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include "movegen.h"
+using namespace std;
+
+// ======================= Perft =======================
+// Count the leaf nodes of the legal move tree. The last ply is counted
+// from the generated list without playing the moves (bulk counting).
+uint64_t perft(Position& pos, int depth) {
+    MoveList moves;
+    generateLegal(pos, moves);
+    if (depth <= 1) return depth == 1 ? moves.size() : 1;
+    uint64_t nodes = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        pos.makeMove(m, undo);
+        nodes += perft(pos, depth - 1);
+        pos.unmakeMove(m, undo);
+    }
+    return nodes;
+}
+
+// Per-root-move counts, for bisecting a mismatch against another engine.
+uint64_t divide(Position& pos, int depth) {
+    MoveList moves;
+    generateLegal(pos, moves);
+    uint64_t total = 0;
+    UndoInfo undo;
+    for (Move m : moves) {
+        pos.makeMove(m, undo);
+        uint64_t n = depth > 1 ? perft(pos, depth - 1) : 1;
+        pos.unmakeMove(m, undo);
+        cout << moveToUci(m) << ": " << n << "\n";
+        total += n;
+    }
+    return total;
+}
+
+// ======================= Reference Suite =======================
+// Standard positions with published node counts (index = depth - 1).
+struct SuiteEntry {
+    const char* name;
+    const char* fen;
+    int depths;
+    uint64_t nodes[6];
+};
+
+const SuiteEntry Suite[] = {
+    { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      5, { 20, 400, 8902, 197281, 4865609 } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      5, { 48, 2039, 97862, 4085603, 193690690 } },
+    { "endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      6, { 14, 191, 2812, 43238, 674624, 11030083 } },
+    { "promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      5, { 6, 264, 9467, 422333, 15833292 } },
+    { "promotions-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+      5, { 6, 264, 9467, 422333, 15833292 } },
+    { "discovered-checks", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      5, { 44, 1486, 62379, 2103487, 89941194 } },
+    { "middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      5, { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void report(uint64_t nodes, double secs) {
+    cout << "Nodes: " << nodes << "  Time: " << secs << " s  NPS: "
+        << (secs > 0 ? (uint64_t)(nodes / secs) : 0) << "\n";
+}
+
+int runSuite(int maxDepth) {
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    auto start = chrono::steady_clock::now();
+    for (const SuiteEntry& e : Suite) {
+        Position pos;
+        pos.setFen(e.fen);
+        for (int d = 1;d <= e.depths && d <= maxDepth;d++) {
+            uint64_t n = perft(pos, d);
+            totalNodes += n;
+            bool ok = n == e.nodes[d - 1];
+            if (!ok) failures++;
+            cout << (ok ? "ok   " : "FAIL ") << e.name << " depth " << d << ": " << n;
+            if (!ok) cout << " (expected " << e.nodes[d - 1] << ")";
+            cout << "\n";
+        }
+    }
+    report(totalNodes, secondsSince(start));
+    cout << (failures ? to_string(failures) + " mismatches\n" : string("All counts match\n"));
+    return failures ? 1 : 0;
+}
+
+void usage() {
+    cout << "Usage: perft [--fen \"<fen>\"] [--depth N] [--divide] [--stats FILE]\n"
+        << "       perft suite [maxDepth]\n";
+}
+
+// ======================= Main =======================
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc > 1 && string(argv[1]) == "suite") {
+        return runSuite(argc > 2 ? atoi(argv[2]) : 6);
+    }
+
+    string fen = Suite[0].fen;
+    int depth = 5;
+    bool split = false;
+    string statsPath;
+    for (int i = 1;i < argc;i++) {
+        string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) fen = argv[++i];
+        else if (arg == "--depth" && i + 1 < argc) depth = atoi(argv[++i]);
+        else if (arg == "--divide") split = true;
+        else if (arg == "--stats" && i + 1 < argc) statsPath = argv[++i];
+        else { usage(); return 2; }
+    }
+
+    Position pos;
+    if (!pos.setFen(fen)) { cout << "Invalid FEN: " << fen << "\n"; return 2; }
+    auto start = chrono::steady_clock::now();
+    uint64_t nodes = split ? divide(pos, depth) : perft(pos, depth);
+    report(nodes, secondsSince(start));
+    if (!statsPath.empty() && !writeStatsFile(statsPath)) { cout << "Cannot write " << statsPath << "\n"; return 1; }
+    return 0;
+}
@@ -0,0 +1,376 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "movegen.h"
+
+// ======================= SAN =======================
+// Standard Algebraic Notation: "Nbd7", "exd6", "O-O", "e8=Q+".
+inline std::string moveToSan(const Position& pos, Move m) {
+    std::string s;
+    int from = moveFrom(m), to = moveTo(m);
+    if (isCastle(m)) s = moveFlag(m) == KING_CASTLE ? "O-O" : "O-O-O";
+    else {
+        PieceType pt = typeOf(pos.pieceOn(from));
+        if (pt == PAWN) {
+            if (isCapture(m)) { s += char('a' + colOf(from)); s += 'x'; }
+            s += squareName(to);
+            if (isPromotion(m)) { s += '='; s += "NBRQ"[promotionType(m) - KNIGHT]; }
+        }
+        else {
+            s += "PNBRQK"[pt];
+            // Name the origin file, rank or both when another piece of the
+            // same kind can reach the same square
+            MoveList moves;
+            generateLegal(pos, moves);
+            bool clash = false, sameFile = false, sameRank = false;
+            for (Move o : moves) {
+                int of = moveFrom(o);
+                if (moveTo(o) != to || of == from || typeOf(pos.pieceOn(of)) != pt) continue;
+                clash = true;
+                if (colOf(of) == colOf(from)) sameFile = true;
+                if (rowOf(of) == rowOf(from)) sameRank = true;
+            }
+            if (clash) {
+                if (!sameFile) s += char('a' + colOf(from));
+                else if (!sameRank) s += char('0' + 8 - rowOf(from));
+                else s += squareName(from);
+            }
+            if (isCapture(m)) s += 'x';
+            s += squareName(to);
+        }
+    }
+    Position next = pos;
+    next.applyMove(m);
+    if (next.inCheck(next.sideToMove)) {
+        MoveList replies;
+        generateLegal(next, replies);
+        s += replies.size() ? '+' : '#';
+    }
+    return s;
+}
+
+// Pseudo-legal moves of one piece type onto one square (no castling). SAN
+// names both, so parsing only needs these rather than the full move list.
+inline void movesOnto(const Position& pos, PieceType pt, int to, PieceType promo, MoveList& list) {
+    Color us = pos.sideToMove, them = !us;
+    Bitboard target = squareBB(to);
+    if (target & pos.pieces(us)) return;
+    bool capture = (target & pos.pieces(them)) != 0;
+    if (pt != PAWN) {
+        for (Bitboard b = attacksFrom(pt, us, to, pos.occupied()) & pos.pieces(us, pt);b;)
+            list.add(encodeMove(popLsb(b), to, capture ? CAPTURE : QUIET));
+        return;
+    }
+    bool lastRank = rowOf(to) == (us == WHITE ? 0 : 7);
+    if (lastRank != (promo != NO_PIECE_TYPE)) return;
+    int promoFlag = lastRank ? promo - KNIGHT : 0;
+    Bitboard pawns = pos.pieces(us, PAWN);
+    if (capture || to == pos.epSquare) {
+        int flag = to == pos.epSquare ? EP_CAPTURE : lastRank ? PROMOTION_CAPTURE + promoFlag : CAPTURE;
+        for (Bitboard b = pawnAttacks(them, to) & pawns;b;) list.add(encodeMove(popLsb(b), to, flag));
+        return;
+    }
+    int back = us == WHITE ? 8 : -8;
+    int from = to + back;
+    if (pawns & squareBB(from)) list.add(encodeMove(from, to, lastRank ? PROMOTION + promoFlag : QUIET));
+    else if (!(pos.occupied() & squareBB(from)) && rowOf(to) == (us == WHITE ? 4 : 3)
+        && (pawns & squareBB(from + back)))
+        list.add(encodeMove(from + back, to, DOUBLE_PUSH));
+}
+
+// The legal move written as SAN, or MOVE_NONE if there is no such move or
+// it is ambiguous. Also takes coordinate forms ("e2e4", "g1-f3", "e7e8q")
+// and castling written with zeros. NUL bytes are kept away from strchr(),
+// which would match its terminator.
+inline Move parseSan(const Position& pos, std::string_view san) {
+    while (!san.empty() && san.back() != '\0' && strchr("+#!?", san.back())) san.remove_suffix(1);
+    if (san.size() < 2) return MOVE_NONE;
+    MoveList moves;
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        generateLegal(pos, moves);
+        int flag = san.size() == 3 ? KING_CASTLE : QUEEN_CASTLE;
+        for (Move m : moves) if (moveFlag(m) == flag) return m;
+        return MOVE_NONE;
+    }
+
+    PieceType pt = PAWN;
+    size_t i = 0;
+    if (const char* p = san[0] != '\0' ? strchr("PNBRQK", san[0]) : nullptr) { pt = PieceType(p - "PNBRQK"); i = 1; }
+
+    PieceType promo = NO_PIECE_TYPE;
+    if (pt == PAWN) {
+        const char* p = san.back() != '\0' ? strchr("NBRQnbrq", san.back()) : nullptr;
+        if (p && san.size() > 2) {
+            promo = PieceType(KNIGHT + (p - "NBRQnbrq") % 4);
+            san.remove_suffix(1);
+            if (san.back() == '=') san.remove_suffix(1);
+        }
+    }
+    if (san.size() < i + 2) return MOVE_NONE;
+    char file = san[san.size() - 2], rank = san[san.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return MOVE_NONE;
+    int to = makeSquare(8 - (rank - '0'), file - 'a');
+
+    int fromCol = -1, fromRow = -1;
+    for (size_t j = i;j + 2 < san.size();j++) {
+        char c = san[j];
+        if (c >= 'a' && c <= 'h') fromCol = c - 'a';
+        else if (c >= '1' && c <= '8') fromRow = 8 - (c - '0');
+        else if (c != 'x' && c != '-' && c != ':') return MOVE_NONE;
+    }
+    // A full origin square without a piece letter is coordinate notation,
+    // which can move any piece
+    bool anyPiece = pt == PAWN && i == 0 && fromCol >= 0 && fromRow >= 0;
+    if (anyPiece) generateLegal(pos, moves);
+    else movesOnto(pos, pt, to, promo, moves);
+
+    CheckInfo ci = computeCheckInfo(pos);
+    Move found = MOVE_NONE;
+    for (Move m : moves) {
+        int from = moveFrom(m);
+        if (moveTo(m) != to) continue;
+        if ((fromCol >= 0 && colOf(from) != fromCol) || (fromRow >= 0 && rowOf(from) != fromRow)) continue;
+        if (isPromotion(m) ? promotionType(m) != promo : promo != NO_PIECE_TYPE) continue;
+        if (!anyPiece && !isLegal(pos, m, ci)) continue;
+        if (found != MOVE_NONE) return MOVE_NONE;
+        found = m;
+    }
+    return found;
+}
+
+// ======================= PGN Reader =======================
+// Tokenizes a whole database held in memory (typically a MappedFile) without
+// copying: tags and results are views into the text. Comments, NAGs and
+// variations are skipped. A game with a bad tag or an illegal move is
+// reported with its byte offset and skipped; reading goes on with the next.
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;     // between the quotes, escapes left as written
+};
+
+// A tag value with its backslash escapes resolved.
+inline std::string pgnUnescape(std::string_view value) {
+    std::string s;
+    for (size_t i = 0;i < value.size();i++) {
+        if (value[i] == '\\' && i + 1 < value.size()) i++;
+        s += value[i];
+    }
+    return s;
+}
+
+struct PgnGame {
+    size_t offset;              // byte offset of the game's first tag or move
+    std::vector<PgnTag> tags;
+    Position start;             // initial position, or the FEN tag's
+    std::vector<Move> moves;
+    std::string_view result;    // "1-0", "0-1", "1/2-1/2", "*", or empty if missing
+
+    std::string_view tag(std::string_view name) const {
+        for (const PgnTag& t : tags) if (t.name == name) return t.value;
+        return std::string_view();
+    }
+};
+
+struct PgnError {
+    size_t offset;
+    std::string message;
+};
+
+class PgnReader {
+public:
+    std::function<void(const PgnError&)> onError;
+    uint64_t badGames;
+
+    explicit PgnReader(std::string_view text) : badGames(0), text(text), at(0) {}
+
+    // Next good game; false at end of input.
+    bool next(PgnGame& game) {
+        for (;;) {
+            skipSpace();
+            if (at >= text.size()) return false;
+            PgnError error;
+            if (readGame(game, error)) return true;
+            badGames++;
+            if (onError) onError(error);
+            skipToNextGame();
+        }
+    }
+
+    size_t offset() const { return at; }
+
+private:
+    std::string_view text;
+    size_t at;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skipSpace() {
+        while (at < text.size() && isSpace(text[at])) at++;
+    }
+
+    void skipLine() {
+        size_t nl = text.find('\n', at);
+        at = nl == std::string_view::npos ? text.size() : nl + 1;
+    }
+
+    // Resume at the next tag section: a '[' line right after a blank line,
+    // so the remaining tags of a broken game are not mistaken for a new one.
+    void skipToNextGame() {
+        for (size_t next = text.find("\n[", at);next != std::string_view::npos;next = text.find("\n[", next + 1)) {
+            size_t prev = next;
+            if (prev > 0 && text[prev - 1] == '\r') prev--;
+            if (prev > 0 && text[prev - 1] == '\n') { at = next + 1; return; }
+        }
+        at = text.size();
+    }
+
+    bool fail(PgnError& error, size_t where, const std::string& message) {
+        error.offset = where;
+        error.message = message;
+        return false;
+    }
+
+    bool readTag(PgnGame& game, PgnError& error) {
+        size_t begin = at++;
+        skipSpace();
+        size_t name = at;
+        while (at < text.size() && !isSpace(text[at]) && text[at] != '"' && text[at] != ']') at++;
+        size_t nameEnd = at;
+        skipSpace();
+        if (nameEnd == name || at >= text.size() || text[at] != '"') return fail(error, begin, "malformed tag");
+        size_t value = ++at;
+        while (at < text.size() && text[at] != '"' && text[at] != '\n') at += text[at] == '\\' ? 2 : 1;
+        if (at >= text.size() || text[at] != '"') return fail(error, begin, "unterminated tag value");
+        game.tags.push_back({ text.substr(name, nameEnd - name), text.substr(value, at - value) });
+        at++;
+        skipSpace();
+        if (at >= text.size() || text[at] != ']') return fail(error, begin, "malformed tag");
+        at++;
+        return true;
+    }
+
+    // Variations may nest and may hold comments with parentheses in them.
+    bool skipVariation(PgnError& error) {
+        size_t begin = at;
+        int depth = 0;
+        while (at < text.size()) {
+            char c = text[at++];
+            if (c == '(') depth++;
+            else if (c == ')' && --depth == 0) return true;
+            else if (c == '{') {
+                size_t close = text.find('}', at);
+                if (close == std::string_view::npos) break;
+                at = close + 1;
+            }
+        }
+        return fail(error, begin, "unterminated variation");
+    }
+
+    bool readGame(PgnGame& game, PgnError& error) {
+        game.offset = at;
+        game.tags.clear();
+        game.moves.clear();
+        game.result = std::string_view();
+
+        while (at < text.size() && text[at] == '[') {
+            if (!readTag(game, error)) return false;
+            skipSpace();
+        }
+        std::string_view fen = game.tag("FEN");
+        if (fen.empty()) game.start.setStartPosition();
+        else if (!game.start.setFen(std::string(fen))) return fail(error, game.offset, "bad FEN tag");
+
+        Position pos = game.start;
+        for (;;) {
+            skipSpace();
+            if (at >= text.size() || text[at] == '[') return true;   // result missing
+            char c = text[at];
+            if (c == '{') {
+                size_t close = text.find('}', at);
+                if (close == std::string_view::npos) return fail(error, at, "unterminated comment");
+                at = close + 1;
+                continue;
+            }
+            if (c == ';' || (c == '%' && (at == 0 || text[at - 1] == '\n'))) { skipLine(); continue; }
+            if (c == '(') {
+                if (!skipVariation(error)) return false;
+                continue;
+            }
+            if (c == '$') {
+                at++;
+                while (at < text.size() && text[at] >= '0' && text[at] <= '9') at++;
+                continue;
+            }
+            if (c == ')' || c == '}' || c == ']') return fail(error, at, std::string("unexpected '") + c + "'");
+
+            size_t begin = at;
+            while (at < text.size() && !isSpace(text[at]) && text[at] != '\0' && !strchr("{}()[];$", text[at])) at++;
+            if (at == begin) return fail(error, begin, "unexpected byte in movetext");
+            std::string_view token = text.substr(begin, at - begin);
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                game.result = token;
+                return true;
+            }
+            // Move numbers: "12." and "12..." alone or glued to the move
+            size_t digits = 0;
+            while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') digits++;
+            if (digits == token.size() || token[digits] == '.') token.remove_prefix(digits);
+            while (!token.empty() && token[0] == '.') token.remove_prefix(1);
+            if (token.empty()) continue;
+
+            Move m = parseSan(pos, token);
+            if (m == MOVE_NONE)
+                return fail(error, begin, "illegal or ambiguous move '" + std::string(token) + "'");
+            game.moves.push_back(m);
+            pos.applyMove(m);
+        }
+    }
+};
+
+// ======================= PGN Writer =======================
+typedef std::vector<std::pair<std::string, std::string>> PgnTagList;
+
+// Tags in the order given, plus SetUp/FEN when the game did not begin from
+// the initial position, then SAN movetext wrapped at 80 columns.
+inline void writePgn(std::ostream& out, const PgnTagList& tags, const Position& start,
+    const std::vector<Move>& moves, const std::string& result) {
+    for (const auto& t : tags) {
+        out << "[" << t.first << " \"";
+        for (char c : t.second) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << "\"]\n";
+    }
+    Position initial;
+    initial.setStartPosition();
+    if (start.key != initial.key || start.fullmoveNumber != 1) {
+        out << "[SetUp \"1\"]\n[FEN \"" << start.fen() << "\"]\n";
+    }
+    out << "\n";
+
+    std::string line;
+    auto emit = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 79) {
+            out << line << "\n";
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += token;
+    };
+    Position pos = start;
+    for (size_t i = 0;i < moves.size();i++) {
+        if (pos.sideToMove == WHITE) emit(std::to_string(pos.fullmoveNumber) + ".");
+        else if (i == 0) emit(std::to_string(pos.fullmoveNumber) + "...");
+        emit(moveToSan(pos, moves[i]));
+        pos.applyMove(moves[i]);
+    }
+    emit(result);
+    out << line << "\n\n";
+}
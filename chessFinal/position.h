@@ -0,0 +1,517 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <type_traits>
+#if defined(HASH_DEBUG)
+#include <iostream>
+#include <cstdlib>
+#endif
+#include "bitboard.h"
+#include "stats.h"
+#include "attacks.h"
+#include "psqt.h"
+
+enum CastlingRight {
+    WHITE_OO = 1, WHITE_OOO = 2, BLACK_OO = 4, BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+// Rights that disappear when a piece moves from or to a given square
+// (king and rook home squares).
+inline int castlingRightsLost(int sq) {
+    switch (sq) {
+    case 60: return WHITE_OO | WHITE_OOO; // e1
+    case 63: return WHITE_OO;             // h1
+    case 56: return WHITE_OOO;            // a1
+    case 4:  return BLACK_OO | BLACK_OOO; // e8
+    case 7:  return BLACK_OO;             // h8
+    case 0:  return BLACK_OOO;            // a8
+    }
+    return 0;
+}
+
+// ======================= Zobrist Keys =======================
+// Random 64-bit keys XOR-ed together to identify a position: one per
+// (piece, square), one for Black to move, one per castling-rights set and
+// one per en-passant file.
+struct ZobristKeys {
+    uint64_t psq[12][64];
+    uint64_t side;
+    uint64_t castling[16];
+    uint64_t epFile[8];
+};
+
+inline ZobristKeys Zobrist;
+
+// Must run once before any position is set up.
+inline void initZobrist() {
+    uint64_t s = 0x2545F4914F6CDD1DULL; // xorshift64*, fixed seed for reproducible keys
+    auto next = [&s]() {
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    };
+    for (int p = 0;p < 12;p++)
+        for (int sq = 0;sq < 64;sq++) Zobrist.psq[p][sq] = next();
+    Zobrist.side = next();
+    // Combined rights hash as the XOR of the single-right keys
+    uint64_t single[4] = { next(), next(), next(), next() };
+    for (int cr = 0;cr < 16;cr++) {
+        Zobrist.castling[cr] = 0;
+        for (int i = 0;i < 4;i++) if (cr & (1 << i)) Zobrist.castling[cr] ^= single[i];
+    }
+    for (int f = 0;f < 8;f++) Zobrist.epFile[f] = next();
+}
+
+// Everything makeMove() overwrites that cannot be recomputed on unmake,
+// and the check info, which is cheaper to restore than to recompute.
+struct UndoInfo {
+    uint8_t captured;       // Piece, or NO_PIECE
+    uint8_t castling;
+    int8_t epSquare;
+    uint16_t halfmoveClock;
+    uint64_t key;
+    Bitboard checkers;
+    Bitboard pinned;
+};
+
+// ======================= Position =======================
+// Bitboard position core: one bitboard per piece type and one per colour
+// (a piece's squares are their intersection), side to move, castling
+// rights and en-passant square, plus the checkers and pins against the
+// side to move. A plain value of 112 bytes with no owned memory, so it can
+// be copied with memcpy, handed to other threads and kept as a snapshot;
+// copy-make (copy, then applyMove) is an alternative to makeMove/unmakeMove.
+struct Position {
+    Bitboard typeBB[6];
+    Bitboard colorBB[2];
+    uint64_t key;       // Zobrist key, kept up to date by makeMove()
+    uint64_t pawnKey;   // Zobrist key of the pawns alone, for the pawn hash table
+    Score psq;          // material + piece-square sum, kept up to date by put/remove/movePiece
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    Color sideToMove;
+    uint8_t castling;
+    int8_t epSquare;    // square a pawn may capture onto, or NO_SQUARE
+    Bitboard checkers;  // enemy pieces giving check to the side to move
+    Bitboard pinned;    // side to move's pieces pinned to its king
+
+    void clear() {
+        for (int i = 0;i < 6;i++) typeBB[i] = 0;
+        colorBB[WHITE] = colorBB[BLACK] = 0;
+        sideToMove = WHITE;
+        castling = 0;
+        epSquare = NO_SQUARE;
+        halfmoveClock = 0;
+        fullmoveNumber = 1;
+        key = 0;
+        psq = 0;
+        pawnKey = 0;
+        checkers = pinned = 0;
+    }
+
+    void setStartPosition() {
+        clear();
+        static const PieceType backRank[8] = { ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK };
+        for (int c = 0;c < 8;c++) {
+            putPiece(makePiece(BLACK, backRank[c]), makeSquare(0, c));
+            putPiece(B_PAWN, makeSquare(1, c));
+            putPiece(W_PAWN, makeSquare(6, c));
+            putPiece(makePiece(WHITE, backRank[c]), makeSquare(7, c));
+        }
+        castling = ALL_CASTLING;
+        key = computeKey();
+        updateCheckInfo();
+    }
+
+    // Read a FEN string ("rnbqkbnr/pppppppp/8/... w KQkq - 0 1"). The move
+    // counters may be omitted, and anything after them is ignored, so EPD
+    // lines parse too. Returns false on malformed input or an impossible
+    // position (missing kings, pawns on the back rank, side not to move in
+    // check). Castling rights without the king and rook at home are dropped,
+    // and so is an en-passant square no double push could have left.
+    bool setFen(const std::string& fen) {
+        clear();
+        std::istringstream in(fen);
+        std::string placement, side, rights, ep;
+        if (!(in >> placement >> side >> rights >> ep)) return false;
+
+        int r = 0, c = 0;
+        for (char ch : placement) {
+            if (ch == '/') {
+                if (c != 8 || ++r > 7) return false;
+                c = 0;
+            }
+            else if (ch >= '1' && ch <= '8') c += ch - '0';
+            else {
+                Piece p = pieceFromSymbol(ch);
+                if (p == NO_PIECE || c > 7) return false;
+                putPiece(p, makeSquare(r, c++));
+            }
+            if (c > 8) return false;
+        }
+        if (r != 7 || c != 8 || (side != "w" && side != "b")) return false;
+        sideToMove = (side == "w") ? WHITE : BLACK;
+
+        for (char ch : rights) {
+            if (ch == 'K') castling |= WHITE_OO;
+            else if (ch == 'Q') castling |= WHITE_OOO;
+            else if (ch == 'k') castling |= BLACK_OO;
+            else if (ch == 'q') castling |= BLACK_OOO;
+            else if (ch != '-') return false;
+        }
+        if (!(pieces(WHITE, KING) & squareBB(60))) castling &= ~(WHITE_OO | WHITE_OOO);
+        if (!(pieces(WHITE, ROOK) & squareBB(63))) castling &= ~WHITE_OO;
+        if (!(pieces(WHITE, ROOK) & squareBB(56))) castling &= ~WHITE_OOO;
+        if (!(pieces(BLACK, KING) & squareBB(4))) castling &= ~(BLACK_OO | BLACK_OOO);
+        if (!(pieces(BLACK, ROOK) & squareBB(7))) castling &= ~BLACK_OO;
+        if (!(pieces(BLACK, ROOK) & squareBB(0))) castling &= ~BLACK_OOO;
+
+        if (ep != "-") {
+            int sq = squareFromName(ep);
+            if (sq == NO_SQUARE) return false;
+            if (couldBeEpSquare(sq)) setEpSquare(sq);
+        }
+        int halfmoves, fullmoves;
+        halfmoveClock = (in >> halfmoves) && halfmoves > 0 ? (uint16_t)std::min(halfmoves, 0xFFFF) : 0;
+        fullmoveNumber = (in >> fullmoves) && fullmoves > 0 ? (uint16_t)std::min(fullmoves, 0xFFFF) : 1;
+        key = computeKey();
+        updateCheckInfo();
+        return isPlausible();
+    }
+
+    // One king per side, no pawns on the back ranks and the side not to
+    // move not in check. Needs updateCheckInfo() to have run.
+    bool isPlausible() const {
+        if (popCount(pieces(WHITE, KING)) != 1 || popCount(pieces(BLACK, KING)) != 1) return false;
+        if ((pieces(WHITE, PAWN) | pieces(BLACK, PAWN)) & (Rank8BB | Rank1BB)) return false;
+        return !inCheck(!sideToMove);
+    }
+
+    // The position as a FEN string; inverse of setFen().
+    std::string fen() const {
+        std::string s;
+        for (int r = 0;r < 8;r++) {
+            int empty = 0;
+            for (int c = 0;c < 8;c++) {
+                Piece p = pieceOn(makeSquare(r, c));
+                if (p == NO_PIECE) { empty++; continue; }
+                if (empty) s += char('0' + empty);
+                empty = 0;
+                s += pieceSymbol(p);
+            }
+            if (empty) s += char('0' + empty);
+            if (r < 7) s += '/';
+        }
+        s += sideToMove == WHITE ? " w " : " b ";
+        if (castling & WHITE_OO) s += 'K';
+        if (castling & WHITE_OOO) s += 'Q';
+        if (castling & BLACK_OO) s += 'k';
+        if (castling & BLACK_OOO) s += 'q';
+        if (!castling) s += '-';
+        s += ' ';
+        s += epSquare == NO_SQUARE ? std::string("-") : squareName(epSquare);
+        s += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+        return s;
+    }
+
+    // True if the opponent's last move could have been a double push over
+    // `sq`: the pushed pawn stands one rank past it, and both the square and
+    // the one the pawn came from are empty. Checks untrusted input only.
+    bool couldBeEpSquare(int sq) const {
+        int row = sideToMove == WHITE ? 2 : 5, dir = sideToMove == WHITE ? 8 : -8;
+        return rowOf(sq) == row && !(occupied() & (squareBB(sq) | squareBB(sq - dir)))
+            && (pieces(!sideToMove, PAWN) & squareBB(sq + dir));
+    }
+
+    // Record an en-passant square only when a pawn of the side to move
+    // can actually capture there, so equal positions get equal keys.
+    void setEpSquare(int sq) {
+        epSquare = (pawnAttacks(!sideToMove, sq) & pieces(sideToMove, PAWN)) ? sq : NO_SQUARE;
+    }
+
+    // Full recomputation; makeMove() keeps `key` equal to this incrementally.
+    uint64_t computeKey() const {
+        uint64_t k = 0;
+        for (int p = 0;p < 12;p++) {
+            for (Bitboard b = pieces(Piece(p));b;) k ^= Zobrist.psq[p][popLsb(b)];
+        }
+        if (sideToMove == BLACK) k ^= Zobrist.side;
+        k ^= Zobrist.castling[castling];
+        if (epSquare != NO_SQUARE) k ^= Zobrist.epFile[colOf(epSquare)];
+        return k;
+    }
+
+    uint64_t computePawnKey() const {
+        uint64_t k = 0;
+        for (Bitboard b = pieces(W_PAWN);b;) k ^= Zobrist.psq[W_PAWN][popLsb(b)];
+        for (Bitboard b = pieces(B_PAWN);b;) k ^= Zobrist.psq[B_PAWN][popLsb(b)];
+        return k;
+    }
+
+    // Checkers and pinned pieces for the side to move, from scratch. makeMove()
+    // and makeNullMove() call this once per move so that every check test,
+    // move generation and mate/stalemate test after it reads them for free.
+    // Code that builds a position by hand calls it once it is complete.
+    void updateCheckInfo() {
+        Color us = sideToMove, them = !us;
+        int k = kingSquare(us);
+        checkers = pinned = 0;
+        if (k == NO_SQUARE) return;
+
+        Bitboard occ = occupied();
+        checkers = attackersTo(k, occ) & pieces(them);
+        Bitboard queens = pieces(them, QUEEN);
+        Bitboard snipers = (rookAttacks(k, 0) & (pieces(them, ROOK) | queens))
+            | (bishopAttacks(k, 0) & (pieces(them, BISHOP) | queens));
+        while (snipers) {
+            Bitboard between = BetweenBB[k][popLsb(snipers)] & occ;
+            if (between && !moreThanOne(between) && (between & pieces(us))) pinned |= between;
+        }
+    }
+
+    // Full recomputation of the incremental material + piece-square score.
+    Score computePsq() const {
+        Score s = 0;
+        for (int p = 0;p < 12;p++) {
+            for (Bitboard b = pieces(Piece(p));b;) s += psqScore(Piece(p), popLsb(b));
+        }
+        return s;
+    }
+
+    // ----- Queries -----
+    Bitboard pieces(Color c, PieceType t) const { return typeBB[t] & colorBB[c]; }
+    Bitboard pieces(Piece p) const { return typeBB[typeOf(p)] & colorBB[colorOf(p)]; }
+    Bitboard pieces(PieceType t) const { return typeBB[t]; }
+    Bitboard pieces(Color c) const { return colorBB[c]; }
+    Bitboard occupied() const { return colorBB[WHITE] | colorBB[BLACK]; }
+
+    Piece pieceOn(int sq) const {
+        Bitboard b = squareBB(sq);
+        if (!(occupied() & b)) return NO_PIECE;
+        Color c = (colorBB[WHITE] & b) ? WHITE : BLACK;
+        for (int t = PAWN;t <= KING;t++) {
+            if (typeBB[t] & b) return makePiece(c, PieceType(t));
+        }
+        return NO_PIECE;
+    }
+
+    int kingSquare(Color c) const {
+        Bitboard k = pieces(c, KING);
+        return k ? lsb(k) : NO_SQUARE;
+    }
+
+    // All pieces of either colour attacking sq, given an occupancy.
+    Bitboard attackersTo(int sq, Bitboard occ) const {
+        return (pawnAttacks(BLACK, sq) & pieces(WHITE, PAWN))
+            | (pawnAttacks(WHITE, sq) & pieces(BLACK, PAWN))
+            | (knightAttacks(sq) & (pieces(WHITE, KNIGHT) | pieces(BLACK, KNIGHT)))
+            | (kingAttacks(sq) & (pieces(WHITE, KING) | pieces(BLACK, KING)))
+            | (rookAttacks(sq, occ) & (pieces(WHITE, ROOK) | pieces(BLACK, ROOK)
+                | pieces(WHITE, QUEEN) | pieces(BLACK, QUEEN)))
+            | (bishopAttacks(sq, occ) & (pieces(WHITE, BISHOP) | pieces(BLACK, BISHOP)
+                | pieces(WHITE, QUEEN) | pieces(BLACK, QUEEN)));
+    }
+
+    // Constant number of table lookups, cheapest pieces first.
+    bool isAttacked(int sq, Color by) const {
+        STATS_SCOPE(STAT_IS_ATTACKED);
+        Bitboard queens = pieces(by, QUEEN);
+        return (pawnAttacks(!by, sq) & pieces(by, PAWN))
+            || (knightAttacks(sq) & pieces(by, KNIGHT))
+            || (kingAttacks(sq) & pieces(by, KING))
+            || (bishopAttacks(sq, occupied()) & (pieces(by, BISHOP) | queens))
+            || (rookAttacks(sq, occupied()) & (pieces(by, ROOK) | queens));
+    }
+
+    // A side without a king (hand-edited save files) is never in check.
+    // For the side to move this is the stored checkers set.
+    bool inCheck(Color c) const {
+        STATS_SCOPE(STAT_IN_CHECK);
+        if (c == sideToMove) return checkers != 0;
+        int k = kingSquare(c);
+        return k != NO_SQUARE && isAttacked(k, !c);
+    }
+
+    // ----- Updates -----
+    void putPiece(Piece p, int sq) {
+        typeBB[typeOf(p)] |= squareBB(sq);
+        colorBB[colorOf(p)] |= squareBB(sq);
+        psq += psqScore(p, sq);
+        if (typeOf(p) == PAWN) pawnKey ^= Zobrist.psq[p][sq];
+    }
+
+    void removePiece(Piece p, int sq) {
+        typeBB[typeOf(p)] &= ~squareBB(sq);
+        colorBB[colorOf(p)] &= ~squareBB(sq);
+        psq -= psqScore(p, sq);
+        if (typeOf(p) == PAWN) pawnKey ^= Zobrist.psq[p][sq];
+    }
+
+    void movePiece(Piece p, int from, int to) {
+        Bitboard fromTo = squareBB(from) | squareBB(to);
+        typeBB[typeOf(p)] ^= fromTo;
+        colorBB[colorOf(p)] ^= fromTo;
+        psq += psqScore(p, to) - psqScore(p, from);
+        if (typeOf(p) == PAWN) pawnKey ^= Zobrist.psq[p][from] ^ Zobrist.psq[p][to];
+    }
+
+    // Play a move produced by the move generator, including captures,
+    // en passant, castling rook moves and promotion. No legality checks.
+    // `undo` receives what unmakeMove() needs to restore this position.
+    void makeMove(Move m, UndoInfo& undo) {
+        STATS_SCOPE(STAT_MAKE);
+        int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+        Piece p = pieceOn(from);
+        Color us = colorOf(p);
+        undo.captured = NO_PIECE;
+        undo.castling = (uint8_t)castling;
+        undo.epSquare = (int8_t)epSquare;
+        undo.halfmoveClock = (uint16_t)halfmoveClock;
+        undo.key = key;
+        undo.checkers = checkers;
+        undo.pinned = pinned;
+
+        uint64_t k = key ^ Zobrist.side ^ Zobrist.castling[castling];
+        if (epSquare != NO_SQUARE) k ^= Zobrist.epFile[colOf(epSquare)];
+
+        if (flag == EP_CAPTURE) {
+            int capSq = epCaptureSquare(to, us);
+            undo.captured = makePiece(!us, PAWN);
+            removePiece(makePiece(!us, PAWN), capSq);
+            k ^= Zobrist.psq[undo.captured][capSq];
+        }
+        else if (isCapture(m)) {
+            undo.captured = pieceOn(to);
+            removePiece(Piece(undo.captured), to);
+            k ^= Zobrist.psq[undo.captured][to];
+        }
+
+        Piece placed = isPromotion(m) ? makePiece(us, promotionType(m)) : p;
+        if (isPromotion(m)) {
+            removePiece(p, from);
+            putPiece(placed, to);
+        }
+        else movePiece(p, from, to);
+        k ^= Zobrist.psq[p][from] ^ Zobrist.psq[placed][to];
+
+        // Castling: move rook too
+        if (isCastle(m)) {
+            Piece rook = makePiece(us, ROOK);
+            movePiece(rook, castlingRookFrom(m), castlingRookTo(m));
+            k ^= Zobrist.psq[rook][castlingRookFrom(m)] ^ Zobrist.psq[rook][castlingRookTo(m)];
+        }
+
+        castling &= ~(castlingRightsLost(from) | castlingRightsLost(to));
+        halfmoveClock = (typeOf(p) == PAWN || isCapture(m)) ? 0 : halfmoveClock + 1;
+        if (us == BLACK) fullmoveNumber++;
+        sideToMove = !us;
+        epSquare = NO_SQUARE;
+        if (flag == DOUBLE_PUSH) setEpSquare((from + to) / 2);
+        if (epSquare != NO_SQUARE) k ^= Zobrist.epFile[colOf(epSquare)];
+        key = k ^ Zobrist.castling[castling];
+        updateCheckInfo();
+        checkKey();
+    }
+
+    // Exact inverse of makeMove(m, undo).
+    void unmakeMove(Move m, const UndoInfo& undo) {
+        STATS_SCOPE(STAT_UNMAKE);
+        int from = moveFrom(m), to = moveTo(m);
+        sideToMove = !sideToMove;
+        Color us = sideToMove;
+        if (us == BLACK) fullmoveNumber--;
+
+        if (isCastle(m)) movePiece(makePiece(us, ROOK), castlingRookTo(m), castlingRookFrom(m));
+        if (isPromotion(m)) {
+            removePiece(makePiece(us, promotionType(m)), to);
+            putPiece(makePiece(us, PAWN), from);
+        }
+        else movePiece(pieceOn(to), to, from);
+
+        if (undo.captured != NO_PIECE)
+            putPiece(Piece(undo.captured), moveFlag(m) == EP_CAPTURE ? epCaptureSquare(to, us) : to);
+
+        castling = undo.castling;
+        epSquare = undo.epSquare;
+        halfmoveClock = undo.halfmoveClock;
+        key = undo.key;
+        checkers = undo.checkers;
+        pinned = undo.pinned;
+        checkKey();
+    }
+
+    // HASH_DEBUG builds verify the incremental keys, piece-square score and
+    // check info after every make/unmake.
+    void checkKey() const {
+#if defined(HASH_DEBUG)
+        if (key != computeKey()) {
+            std::cerr << "Zobrist key mismatch: " << std::hex << key << " != " << computeKey() << "\n";
+            std::abort();
+        }
+        if (pawnKey != computePawnKey()) {
+            std::cerr << "Pawn key mismatch: " << std::hex << pawnKey << " != " << computePawnKey() << "\n";
+            std::abort();
+        }
+        if (psq != computePsq()) {
+            std::cerr << "PSQ score mismatch: " << psq << " != " << computePsq() << "\n";
+            std::abort();
+        }
+        Position fresh = *this;
+        fresh.updateCheckInfo();
+        if (checkers != fresh.checkers || pinned != fresh.pinned) {
+            std::cerr << "Check info mismatch: " << std::hex << checkers << "/" << pinned
+                << " != " << fresh.checkers << "/" << fresh.pinned << "\n";
+            std::abort();
+        }
+#endif
+    }
+
+    // Pass the turn without moving (null-move pruning in search).
+    void makeNullMove(UndoInfo& undo) {
+        undo.captured = NO_PIECE;
+        undo.castling = (uint8_t)castling;
+        undo.epSquare = (int8_t)epSquare;
+        undo.halfmoveClock = (uint16_t)halfmoveClock;
+        undo.key = key;
+        undo.checkers = checkers;
+        undo.pinned = pinned;
+        if (epSquare != NO_SQUARE) key ^= Zobrist.epFile[colOf(epSquare)];
+        key ^= Zobrist.side;
+        epSquare = NO_SQUARE;
+        halfmoveClock++;
+        sideToMove = !sideToMove;
+        updateCheckInfo();
+        checkKey();
+    }
+
+    void unmakeNullMove(const UndoInfo& undo) {
+        sideToMove = !sideToMove;
+        epSquare = undo.epSquare;
+        halfmoveClock = undo.halfmoveClock;
+        key = undo.key;
+        checkers = undo.checkers;
+        pinned = undo.pinned;
+    }
+
+    // makeMove() for callers that never take the move back.
+    void applyMove(Move m) {
+        UndoInfo undo;
+        makeMove(m, undo);
+    }
+
+    // Copy-make: the position after m, leaving this one as it was.
+    Position after(Move m) const {
+        Position next = *this;
+        next.applyMove(m);
+        return next;
+    }
+
+    // The pawn taken by an en-passant capture landing on `to`.
+    static int epCaptureSquare(int to, Color us) { return to + ((us == WHITE) ? 8 : -8); }
+    static int castlingRookFrom(Move m) { return moveFlag(m) == KING_CASTLE ? moveFrom(m) + 3 : moveFrom(m) - 4; }
+    static int castlingRookTo(Move m) { return moveFlag(m) == KING_CASTLE ? moveTo(m) - 1 : moveTo(m) + 1; }
+};
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position must stay a plain value");
+static_assert(sizeof(Position) <= 112, "Position should fit in 112 bytes");
@@ -0,0 +1,124 @@
+#pragma once
+#include "bitboard.h"
+
+// ======================= Tapered Scores =======================
+// A middlegame and an endgame value packed into one int, so both phases
+// are summed with a single add. The evaluator blends them by game phase.
+typedef int32_t Score;
+
+constexpr Score makeScore(int mg, int eg) { return (Score)((uint32_t)eg << 16) + mg; }
+constexpr int mgValue(Score s) { return int16_t(uint16_t(uint32_t(s))); }
+constexpr int egValue(Score s) { return int16_t(uint16_t(uint32_t(s + 0x8000) >> 16)); }
+
+// ======================= Piece-Square Tables =======================
+// Written from White's side with rank 8 on the first line, which matches
+// square numbering (a8 = 0), so a White piece on sq reads table[sq] and a
+// Black piece reads the vertically mirrored square, sq ^ 56.
+constexpr int MaterialMg[6] = { 82, 337, 365, 477, 1025, 0 };
+constexpr int MaterialEg[6] = { 94, 281, 297, 512, 936, 0 };
+
+constexpr int PawnMg[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+     50, 50, 50, 50, 50, 50, 50, 50,
+     10, 10, 20, 30, 30, 20, 10, 10,
+      5,  5, 10, 25, 25, 10,  5,  5,
+      0,  0,  0, 20, 20,  0,  0,  0,
+      5, -5,-10,  0,  0,-10, -5,  5,
+      5, 10, 10,-20,-20, 10, 10,  5,
+      0,  0,  0,  0,  0,  0,  0,  0 };
+
+constexpr int PawnEg[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+     60, 60, 60, 60, 60, 60, 60, 60,
+     40, 40, 40, 40, 40, 40, 40, 40,
+     25, 25, 25, 25, 25, 25, 25, 25,
+     15, 15, 15, 15, 15, 15, 15, 15,
+      5,  5,  5,  5,  5,  5,  5,  5,
+      0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0 };
+
+constexpr int KnightPst[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50 };
+
+constexpr int BishopPst[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20 };
+
+constexpr int RookPst[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0 };
+
+constexpr int QueenPst[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20 };
+
+// The king hides behind its pawns in the middlegame and centralises once
+// the queens are off.
+constexpr int KingMg[64] = {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20 };
+
+constexpr int KingEg[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50 };
+
+// Material plus placement for every (piece, square), White positive and
+// Black negative, so a position's total is just the sum over its pieces.
+struct PsqTable {
+    Score v[12][64];
+};
+
+constexpr PsqTable buildPsq() {
+    const int* mg[6] = { PawnMg, KnightPst, BishopPst, RookPst, QueenPst, KingMg };
+    const int* eg[6] = { PawnEg, KnightPst, BishopPst, RookPst, QueenPst, KingEg };
+    PsqTable t{};
+    for (int pt = 0;pt < 6;pt++) {
+        for (int sq = 0;sq < 64;sq++) {
+            Score s = makeScore(MaterialMg[pt] + mg[pt][sq], MaterialEg[pt] + eg[pt][sq]);
+            t.v[pt][sq] = s;              // White piece
+            t.v[pt + 6][sq ^ 56] = -s;    // Black piece on the mirrored square
+        }
+    }
+    return t;
+}
+
+inline constexpr PsqTable Psq = buildPsq();
+
+inline Score psqScore(Piece p, int sq) { return Psq.v[p][sq]; }
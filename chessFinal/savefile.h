@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "position.h"
+
+// ======================= Save Files =======================
+// The game's own text format: "FEN <fen>", "HISTORY", then one coordinate
+// move ("e2e4", "e7e8q") per line for every move of the game so far.
+inline void writeSaveFile(std::ostream& out, const Position& pos, const std::vector<std::string>& history) {
+    out << "FEN " << pos.fen() << "\n";
+    out << "HISTORY\n";
+    for (auto& m : history) out << m << "\n";
+}
+
+// Files from older versions hold an 8-line board dump instead of the FEN
+// line; for those the side to move comes from the history length and
+// castling rights are lost. Returns false on a malformed file, including
+// a board that fails the same sanity checks setFen() applies.
+inline bool readSaveFile(std::istream& in, Position& pos, std::vector<std::string>& history) {
+    std::string first;
+    if (!std::getline(in, first)) return false;
+    history.clear();
+    if (first.compare(0, 4, "FEN ") == 0) {
+        if (!pos.setFen(first.substr(4))) return false;
+    }
+    else {
+        pos.clear();
+        for (int r = 0;r < 8;r++) {
+            std::string line = first;
+            if (r > 0) std::getline(in, line);
+            if (line.size() < 8) return false;
+            for (int c = 0;c < 8;c++) {
+                Piece p = pieceFromSymbol(line[c]);
+                if (p != NO_PIECE) pos.putPiece(p, makeSquare(r, c));
+            }
+        }
+    }
+    std::string marker; std::getline(in, marker);
+    std::string move;
+    while (std::getline(in, move)) {
+        if (!move.empty() && move.back() == '\r') move.pop_back();
+        if (move.size() == 4 || move.size() == 5) history.push_back(move);
+    }
+    if (first.compare(0, 4, "FEN ") == 0) return true;
+
+    pos.sideToMove = (history.size() % 2 == 0) ? WHITE : BLACK;
+    // Restore the en-passant square if the last move was a pawn double step
+    if (!history.empty()) {
+        std::string last = history.back();
+        for (int i = 0;i < 4;i += 2) {
+            if (last[i] < 'a' || last[i] > 'h' || last[i + 1] < '1' || last[i + 1] > '8') return false;
+        }
+        int sr = 8 - (last[1] - '0');
+        int sc = last[0] - 'a';
+        int er = 8 - (last[3] - '0');
+        int ec = last[2] - 'a';
+        Piece moved = pos.pieceOn(makeSquare(er, ec));
+        if (moved != NO_PIECE && typeOf(moved) == PAWN && sc == ec && std::abs(er - sr) == 2) {
+            pos.setEpSquare(makeSquare((sr + er) / 2, sc));
+        }
+    }
+    pos.key = pos.computeKey();
+    pos.updateCheckInfo();
+    return pos.isPlausible();
+}
@@ -0,0 +1,345 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "movegen.h"
+#include "evaluate.h"
+#include "tt.h"
+
+// ======================= Search Limits and Results =======================
+const int MAX_PLY = 64;
+const int INF_SCORE = 32001;
+const int MATE_SCORE = 32000;
+const int MATE_BOUND = MATE_SCORE - 256;       // scores beyond this are mates; tablebase mates run past MAX_PLY
+const int HISTORY_MAX = 1 << 16;               // history scores stay below the killer band in moveScore()
+
+struct SearchLimits {
+    int depth;              // deepest iteration to run
+    int64_t movetimeMs;     // 0 = no time limit
+    uint64_t nodes;         // 0 = no node limit (checked every 2048 nodes, per thread)
+    SearchLimits() : depth(MAX_PLY - 1), movetimeMs(0), nodes(0) {}
+};
+
+// Principal variation held in place, so search results copy without
+// touching the heap.
+struct PrincipalVariation {
+    Move moves[MAX_PLY];
+    int length;
+
+    PrincipalVariation() : length(0) {}
+    void assign(const Move* first, const Move* last) {
+        length = int(last - first);
+        memcpy(moves, first, length * sizeof(Move));
+    }
+    void push_back(Move m) { if (length < MAX_PLY) moves[length++] = m; }
+    bool empty() const { return length == 0; }
+    int size() const { return length; }
+    Move operator[](int i) const { return moves[i]; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + length; }
+};
+
+// Outcome of one completed iterative-deepening iteration.
+struct SearchInfo {
+    int depth;
+    int score;              // centipawns from the side to move's view
+    uint64_t nodes;
+    int64_t elapsedMs;
+    PrincipalVariation pv;
+    uint64_t ttProbes, ttHits;
+    int hashfull;           // permille of the table filled by this search
+    uint64_t pawnProbes, pawnHits;
+
+    SearchInfo() : depth(0), score(0), nodes(0), elapsedMs(0), ttProbes(0), ttHits(0), hashfull(0), pawnProbes(0), pawnHits(0) {}
+    double ttHitRate() const { return ttProbes ? 100.0 * ttHits / ttProbes : 0.0; }
+    double pawnHitRate() const { return pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0; }
+    Move bestMove() const { return pv.empty() ? MOVE_NONE : pv[0]; }
+    uint64_t nps() const { return elapsedMs > 0 ? nodes * 1000 / elapsedMs : nodes * 1000; }
+};
+
+// Thinking time for one move on a clock: an even share of the moves to
+// the next time control (30 when unknown) plus most of the increment,
+// never more than half of what is left so a late poll cannot flag.
+inline int64_t allocateTime(int64_t remainingMs, int64_t incMs, int movesToGo = 0) {
+    int64_t t = remainingMs / (movesToGo > 0 ? movesToGo : 30) + incMs * 3 / 4;
+    if (t > remainingMs / 2) t = remainingMs / 2;
+    return t > 1 ? t : 1;
+}
+
+// "cp 35" or "mate 3" (negative when the side to move gets mated).
+inline std::string scoreToString(int score) {
+    if (score > MATE_BOUND) return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+    if (score < -MATE_BOUND) return "mate -" + std::to_string((MATE_SCORE + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+// Mate scores are stored relative to the node, not the root, so they stay
+// correct when the same position is reached at another ply.
+inline int scoreToTT(int score, int ply) {
+    return score > MATE_BOUND ? score + ply : score < -MATE_BOUND ? score - ply : score;
+}
+
+inline int scoreFromTT(int score, int ply) {
+    return score > MATE_BOUND ? score - ply : score < -MATE_BOUND ? score + ply : score;
+}
+
+// ======================= Searcher =======================
+// Iterative-deepening negamax with alpha-beta, quiescence search on
+// captures, null-move pruning and move ordering by MVV-LVA, killer moves
+// and the history heuristic.
+class Searcher {
+public:
+    std::atomic<bool> stopRequested;    // set from any thread; cleared by the caller before think()
+    std::atomic<uint64_t> publishedNodes; // node count, refreshed every 2048 nodes for other threads
+    std::function<void(const SearchInfo&)> onIteration;  // called after every completed depth
+    TranspositionTable* tt;         // shared table, or nullptr to search without one
+    int threadIndex;                // 0 for the main search; odd helpers skip depth 1
+
+    Searcher() : stopRequested(false), publishedNodes(0), tt(nullptr), threadIndex(0) {}
+
+    // gameKeys: keys of the positions played so far (for repetition draws),
+    // ending with the root position's key. The caller starts a new table
+    // generation (tt->newSearch()) once per move, however many threads run.
+    SearchInfo think(const Position& root, const std::vector<uint64_t>& gameKeys, const SearchLimits& limits) {
+        STATS_SCOPE(STAT_SEARCH);
+        pos = root;
+        // Room for a long game up front, then grown geometrically, so one
+        // more game move does not mean a new buffer
+        size_t needed = gameKeys.size() + MAX_PLY + 1;
+        if (keys.capacity() < needed) keys.reserve(std::max<size_t>(2 * needed, 1024));
+        keys.assign(gameKeys.begin(), gameKeys.end());
+        if (keys.empty() || keys.back() != pos.key) keys.push_back(pos.key);
+        nodes = ttProbes = ttHits = 0;
+        pawnTable.probes = pawnTable.hits = 0;
+        publishedNodes = 0;
+        stopped = false;
+        this->limits = limits;
+        start = std::chrono::steady_clock::now();
+        memset(killers, 0, sizeof(killers));
+        memset(history, 0, sizeof(history));
+
+        SearchInfo best;
+        for (int depth = 1 + (threadIndex & 1);depth <= limits.depth && depth < MAX_PLY;depth++) {
+            int score = negamax(-INF_SCORE, INF_SCORE, depth, 0);
+            if (stopped) break;
+            best.depth = depth;
+            best.score = score;
+            best.nodes = nodes;
+            best.elapsedMs = elapsedMs();
+            best.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+            fillStats(best);
+            if (onIteration) onIteration(best);
+            if (score > MATE_BOUND || score < -MATE_BOUND) break;
+        }
+        // Interrupted before depth 1 finished: fall back to any legal move
+        if (best.pv.empty()) {
+            MoveList moves;
+            generateLegal(root, moves);
+            if (moves.size() > 0) best.pv.push_back(moves[0]);
+        }
+        best.nodes = nodes;
+        best.elapsedMs = elapsedMs();
+        publishedNodes = nodes;
+        fillStats(best);
+        return best;
+    }
+
+    uint64_t nodeCount() const { return nodes; }
+
+private:
+    Position pos;
+    std::vector<uint64_t> keys;     // game history + current search path
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point start;
+    uint64_t nodes;
+    uint64_t ttProbes, ttHits;      // counted per searcher, so threads never share a counter
+    bool stopped;
+    Move killers[MAX_PLY][2];
+    int history[12][64];            // quiet-move cutoff scores by (piece, to), at most HISTORY_MAX
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    PawnHashTable pawnTable;        // per thread, kept across searches
+
+    void fillStats(SearchInfo& info) const {
+        info.ttProbes = ttProbes;
+        info.ttHits = ttHits;
+        info.hashfull = tt ? tt->hashfull() : 0;
+        info.pawnProbes = pawnTable.probes;
+        info.pawnHits = pawnTable.hits;
+    }
+
+    int64_t elapsedMs() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Polled every 2048 nodes so the clock is not read on every node.
+    void checkTime() {
+        if ((nodes & 2047) != 0) return;
+        publishedNodes.store(nodes, std::memory_order_relaxed);
+        if (stopRequested || (limits.nodes > 0 && nodes >= limits.nodes)
+            || (limits.movetimeMs > 0 && elapsedMs() >= limits.movetimeMs)) stopped = true;
+    }
+
+    // Fifty-move rule or a repeat of any position since the last
+    // irreversible move.
+    bool isDraw() const {
+        if (pos.halfmoveClock >= 100) return true;
+        int last = (int)keys.size() - 1;
+        int oldest = last - pos.halfmoveClock;
+        if (oldest < 0) oldest = 0;
+        for (int i = last - 2;i >= oldest;i -= 2) {
+            if (keys[i] == pos.key) return true;
+        }
+        return false;
+    }
+
+    bool hasNonPawnMaterial(Color c) const {
+        return (pos.pieces(c) & ~pos.pieces(c, PAWN) & ~pos.pieces(c, KING)) != 0;
+    }
+
+    // ----- Move ordering -----
+    int moveScore(Move m, int ply, Move ttMove) const {
+        if (m == ttMove) return 2000000;
+        if (isCapture(m)) {
+            PieceType victim = moveFlag(m) == EP_CAPTURE ? PAWN : typeOf(pos.pieceOn(moveTo(m)));
+            PieceType attacker = typeOf(pos.pieceOn(moveFrom(m)));
+            return 1000000 + 10 * PieceValue[victim] - PieceValue[attacker] / 10;
+        }
+        if (isPromotion(m)) return 900000 + PieceValue[promotionType(m)];
+        if (m == killers[ply][0]) return 800000;
+        if (m == killers[ply][1]) return 700000;
+        return history[pos.pieceOn(moveFrom(m))][moveTo(m)];
+    }
+
+    // Selection sort step: bring the best remaining move to index i.
+    static void pickNext(MoveList& moves, int scores[], int i) {
+        int best = i;
+        for (int j = i + 1;j < moves.count;j++) if (scores[j] > scores[best]) best = j;
+        std::swap(moves.moves[i], moves.moves[best]);
+        std::swap(scores[i], scores[best]);
+    }
+
+    // ----- Search -----
+    int negamax(int alpha, int beta, int depth, int ply) {
+        pvLength[ply] = 0;
+        nodes++;
+        checkTime();
+        if (stopped) return 0;
+        if (ply > 0 && isDraw()) return 0;
+
+        bool inCheck = pos.inCheck(pos.sideToMove);
+        if (inCheck) depth++;
+        if (depth <= 0 || ply >= MAX_PLY - 1) return quiesce(alpha, beta, ply);
+
+        // A stored result searched at least this deep may settle the node
+        Move ttMove = MOVE_NONE;
+        TTData entry;
+        if (tt && (ttProbes++, tt->probe(pos.key, entry))) {
+            ttHits++;
+            ttMove = entry.move;
+            int ttScore = scoreFromTT(entry.score, ply);
+            if (ply > 0 && entry.depth >= depth
+                && (entry.bound == BOUND_EXACT
+                    || (entry.bound == BOUND_LOWER && ttScore >= beta)
+                    || (entry.bound == BOUND_UPPER && ttScore <= alpha)))
+                return ttScore;
+        }
+
+        // Null move: if passing still fails high, a real move will too
+        if (!inCheck && ply > 0 && depth >= 3 && beta < MATE_BOUND && hasNonPawnMaterial(pos.sideToMove)
+            && evaluate(pos, &pawnTable) >= beta) {
+            UndoInfo undo;
+            pos.makeNullMove(undo);
+            keys.push_back(pos.key);
+            int score = -negamax(-beta, -beta + 1, depth - 3, ply + 1);
+            keys.pop_back();
+            pos.unmakeNullMove(undo);
+            if (stopped) return 0;
+            if (score >= beta) return beta;
+        }
+
+        MoveList moves;
+        generateLegal(pos, moves);
+        if (moves.size() == 0) return inCheck ? -MATE_SCORE + ply : 0;
+
+        int scores[MAX_MOVES];
+        for (int i = 0;i < moves.count;i++) scores[i] = moveScore(moves[i], ply, ttMove);
+
+        int alphaOrig = alpha;
+        Move bestMove = MOVE_NONE;
+        for (int i = 0;i < moves.count;i++) {
+            pickNext(moves, scores, i);
+            Move m = moves[i];
+            UndoInfo undo;
+            pos.makeMove(m, undo);
+            keys.push_back(pos.key);
+            int score = -negamax(-beta, -alpha, depth - 1, ply + 1);
+            keys.pop_back();
+            pos.unmakeMove(m, undo);
+            if (stopped) return 0;
+
+            if (score > alpha) {
+                alpha = score;
+                bestMove = m;
+                pvTable[ply][0] = m;
+                memcpy(&pvTable[ply][1], pvTable[ply + 1], pvLength[ply + 1] * sizeof(Move));
+                pvLength[ply] = pvLength[ply + 1] + 1;
+            }
+            if (alpha >= beta) {
+                if (!isCapture(m) && !isPromotion(m)) {
+                    if (killers[ply][0] != m) {
+                        killers[ply][1] = killers[ply][0];
+                        killers[ply][0] = m;
+                    }
+                    // History gravity: the bonus shrinks as the entry nears
+                    // HISTORY_MAX, so the entry never passes it
+                    int& h = history[pos.pieceOn(moveFrom(m))][moveTo(m)];
+                    int bonus = depth * depth;
+                    h += bonus - h * bonus / HISTORY_MAX;
+                }
+                break;
+            }
+        }
+        if (tt) {
+            Bound bound = alpha >= beta ? BOUND_LOWER : alpha > alphaOrig ? BOUND_EXACT : BOUND_UPPER;
+            tt->store(pos.key, bestMove, scoreToTT(alpha, ply), depth, bound);
+        }
+        return alpha;
+    }
+
+    // Captures and promotions only, until the position is quiet.
+    int quiesce(int alpha, int beta, int ply) {
+        pvLength[ply] = 0;
+        nodes++;
+        checkTime();
+        if (stopped) return 0;
+
+        int standPat = evaluate(pos, &pawnTable);
+        if (standPat >= beta || ply >= MAX_PLY - 1) return standPat;
+        if (standPat > alpha) alpha = standPat;
+
+        MoveList moves;
+        generateCaptures(pos, moves);
+        int scores[MAX_MOVES];
+        for (int i = 0;i < moves.count;i++) scores[i] = moveScore(moves[i], ply, MOVE_NONE);
+
+        for (int i = 0;i < moves.count;i++) {
+            pickNext(moves, scores, i);
+            Move m = moves[i];
+            UndoInfo undo;
+            pos.makeMove(m, undo);
+            int score = -quiesce(-beta, -alpha, ply + 1);
+            pos.unmakeMove(m, undo);
+            if (stopped) return 0;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+        return alpha;
+    }
+};
@@ -0,0 +1,639 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "search.h"
+
+// ======================= Game Server =======================
+// Many games in one process, driven by a line protocol on stdin/stdout or
+// on a Unix domain socket (any number of clients, each with any number of
+// games). Every request is one line; replies name the session they are
+// about, because AI moves finish out of order:
+//   new [fen <FEN>]                    -> new <id>
+//   move <id> <uci>                    -> moved <id> <uci> <status>
+//   go <id> [depth D] [movetime ms] [nodes N]
+//                                      -> bestmove <id> <uci> <status>, later
+//                                         (movetime and nodes are capped by the server)
+//   fen <id>                           -> fen <id> <FEN>
+//   close <id>                         -> closed <id>
+//   stats                              -> stats sessions N/M queued N/M ...
+//   quit                               ends this connection; shutdown ends the server
+// <status> is playing, check, checkmate, stalemate, repetition or fifty.
+// Failures answer "error <id> <reason>" ("error - ..." without a session).
+//
+// One thread runs the event loop: it reads requests, plays human moves
+// and answers everything but "go", which it queues for a pool of worker
+// threads with their own searchers and hash tables. Finished searches
+// come back through a queue and a wake-up pipe, and the loop plays the
+// move and replies. Back-pressure works at two levels:
+//   - the AI queue is bounded; a "go" that finds it full is answered
+//     "busy <id>" at once, and the client tries again later
+//   - a client whose replies pile up unread stops being read until it
+//     catches up, so one slow reader cannot grow the server's memory;
+//     in stdio mode stdout is made non-blocking and polled for this
+const int SESSION_KEYS = 102;       // positions since the last capture or pawn move; fifty moves end the game
+
+enum SessionStatus {
+    SESSION_PLAYING, SESSION_CHECK, SESSION_CHECKMATE, SESSION_STALEMATE, SESSION_REPETITION, SESSION_FIFTY_MOVES
+};
+
+inline const char* sessionStatusName(SessionStatus s) {
+    static const char* names[] = { "playing", "check", "checkmate", "stalemate", "repetition", "fifty" };
+    return names[s];
+}
+
+// A game's whole state in about 1 KB and no owned memory, so thousands
+// of them sit in one preallocated array. Only the keys that a repetition
+// can still match are kept: a capture or pawn move clears them.
+struct SessionBoard {
+    Position pos;
+    uint64_t keys[SESSION_KEYS];    // keys[0..keyCount), ending with pos.key
+    uint32_t generation;            // bumped on release, so stale ids are refused
+    uint16_t keyCount;
+    int32_t owner;                  // connection index, -1 while free
+    bool thinking;                  // a worker has it; the loop leaves it alone
+    bool closing;                   // closed while thinking: released when the search returns
+
+    void reset(const Position& start, int connection) {
+        pos = start;
+        keys[0] = pos.key;
+        keyCount = 1;
+        owner = connection;
+        thinking = closing = false;
+    }
+
+    void play(Move m) {
+        pos.applyMove(m);
+        if (pos.halfmoveClock == 0 || keyCount == SESSION_KEYS) keyCount = 0;
+        keys[keyCount++] = pos.key;
+    }
+
+    // Check and mate come from the checkers the position keeps up to date.
+    SessionStatus status() const {
+        bool check = pos.inCheck(pos.sideToMove);
+        if (!hasLegalMoves(pos)) return check ? SESSION_CHECKMATE : SESSION_STALEMATE;
+        if (pos.halfmoveClock >= 100) return SESSION_FIFTY_MOVES;
+        int repeats = 0;
+        for (int i = keyCount - 3;i >= 0;i -= 2) {
+            if (keys[i] == pos.key) repeats++;
+        }
+        if (repeats >= 2) return SESSION_REPETITION;
+        return check ? SESSION_CHECK : SESSION_PLAYING;
+    }
+
+    bool gameOver() const {
+        SessionStatus s = status();
+        return s != SESSION_PLAYING && s != SESSION_CHECK;
+    }
+};
+
+static_assert(std::is_trivially_copyable<SessionBoard>::value, "SessionBoard must stay a plain value");
+
+// Fixed number of boards allocated up front, handed out from a free list.
+// An id is generation * capacity + slot, so it names one game for good.
+class SessionPool {
+public:
+    explicit SessionPool(size_t capacity) : boards(capacity ? capacity : 1) {
+        freeSlots.reserve(boards.size());
+        for (size_t i = boards.size();i-- > 0;) {
+            boards[i].generation = 0;
+            boards[i].owner = -1;
+            freeSlots.push_back((uint32_t)i);
+        }
+    }
+
+    size_t capacity() const { return boards.size(); }
+    size_t inUse() const { return boards.size() - freeSlots.size(); }
+
+    // nullptr when every board is taken.
+    SessionBoard* acquire() {
+        if (freeSlots.empty()) return nullptr;
+        SessionBoard* b = &boards[freeSlots.back()];
+        freeSlots.pop_back();
+        return b;
+    }
+
+    void release(SessionBoard* b) {
+        b->generation++;
+        b->owner = -1;
+        freeSlots.push_back(slot(b));
+    }
+
+    // nullptr for ids that were never handed out or are closed.
+    SessionBoard* find(uint64_t id) {
+        uint64_t s = id % boards.size();
+        SessionBoard& b = boards[s];
+        return b.owner >= 0 && b.generation == id / boards.size() ? &b : nullptr;
+    }
+
+    uint64_t id(const SessionBoard* b) const { return (uint64_t)b->generation * boards.size() + slot(b); }
+    uint32_t slot(const SessionBoard* b) const { return uint32_t(b - boards.data()); }
+    SessionBoard& at(uint32_t s) { return boards[s]; }
+
+private:
+    std::vector<SessionBoard> boards;
+    std::vector<uint32_t> freeSlots;
+};
+
+// ======================= AI Worker Pool =======================
+struct AiJob {
+    uint32_t slot;
+    SearchLimits limits;
+};
+
+struct AiResult {
+    uint32_t slot;
+    Move move;
+};
+
+// Workers take jobs in arrival order from a fixed ring and post results
+// to a list the event loop drains. A worker reads its session's board in
+// place: the loop does not touch a board while it is thinking.
+class AiWorkers {
+public:
+    AiWorkers(SessionPool& pool, int threads, size_t maxQueued, size_t hashMb)
+        : pool(pool), ring(maxQueued ? maxQueued : 1), head(0), queued(0), quitting(false), wakeWrite(-1) {
+        for (int i = 0;i < threads;i++) {
+            workers.emplace_back(new Worker());
+            workers.back()->tt.resize(hashMb);
+            workers.back()->searcher.tt = &workers.back()->tt;
+            workers.back()->keys.reserve(SESSION_KEYS);
+        }
+        finished.reserve(ring.size() + workers.size());
+    }
+
+    ~AiWorkers() { stop(); }
+
+    // wakeFd is written to whenever finished results are waiting.
+    void start(int wakeFd) {
+        wakeWrite = wakeFd;
+        for (size_t i = 0;i < workers.size();i++) workers[i]->thread = std::thread(&AiWorkers::run, this, workers[i].get());
+    }
+
+    // Searches in flight are stopped too, so shutdown does not wait for them.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            quitting = true;
+            for (auto& w : workers) w->searcher.stopRequested = true;
+        }
+        jobReady.notify_all();
+        for (auto& w : workers) if (w->thread.joinable()) w->thread.join();
+    }
+
+    // False when the queue is full.
+    bool submit(const AiJob& job) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (queued == ring.size()) return false;
+            ring[(head + queued) % ring.size()] = job;
+            queued++;
+        }
+        jobReady.notify_one();
+        return true;
+    }
+
+    // Moves results into out, which is cleared first.
+    void collect(std::vector<AiResult>& out) {
+        out.clear();
+        std::lock_guard<std::mutex> guard(lock);
+        out.swap(finished);
+    }
+
+    size_t queueLength() {
+        std::lock_guard<std::mutex> guard(lock);
+        return queued;
+    }
+    size_t queueCapacity() const { return ring.size(); }
+    int threadCount() const { return (int)workers.size(); }
+
+private:
+    struct Worker {
+        Searcher searcher;
+        TranspositionTable tt;
+        std::vector<uint64_t> keys;
+        std::thread thread;
+    };
+
+    SessionPool& pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<AiJob> ring;
+    size_t head, queued;
+    std::vector<AiResult> finished;
+    std::mutex lock;
+    std::condition_variable jobReady;
+    bool quitting;
+    int wakeWrite;
+
+    void run(Worker* w) {
+        while (true) {
+            AiJob job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                jobReady.wait(guard, [this]() { return quitting || queued > 0; });
+                if (quitting) return;
+                job = ring[head];
+                head = (head + 1) % ring.size();
+                queued--;
+                // Under the lock, so a stop() from now on is not lost
+                w->searcher.stopRequested = false;
+            }
+            const SessionBoard& b = pool.at(job.slot);
+            w->keys.assign(b.keys, b.keys + b.keyCount);
+            w->tt.newSearch();
+            Move m = w->searcher.think(b.pos, w->keys, job.limits).bestMove();
+            // A time or node limit can end the search before depth 1 completes
+            if (m == MOVE_NONE) {
+                MoveList list;
+                generateLegal(b.pos, list);
+                if (list.size() > 0) m = list[0];
+            }
+            bool wasEmpty;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                wasEmpty = finished.empty();
+                finished.push_back({ job.slot, m });
+            }
+            if (wasEmpty) {
+                char byte = 1;
+                while (write(wakeWrite, &byte, 1) < 0 && errno == EINTR) {}
+            }
+        }
+    }
+};
+
+// ======================= Event Loop =======================
+struct ServerOptions {
+    std::string socketPath;         // empty: one client on stdin/stdout
+    int workers;
+    size_t sessions;                // most games open at once
+    size_t maxQueued;               // AI requests waiting for a worker
+    size_t hashMb;                  // per worker
+    int depth;                      // search depth when "go" gives no limit
+    int64_t maxMovetimeMs;          // longest search a client can ask for, whatever its limits
+    uint64_t maxNodes;              // most nodes a client can ask for
+
+    ServerOptions() : workers(1), sessions(10000), maxQueued(1024), hashMb(4), depth(4),
+        maxMovetimeMs(10000), maxNodes(100000000) {}
+};
+
+class GameServer {
+public:
+    explicit GameServer(const ServerOptions& options)
+        : opt(options), pool(options.sessions), ai(pool, options.workers < 1 ? 1 : options.workers, options.maxQueued, options.hashMb),
+          listenFd(-1), stdoutFlags(-1), running(true), movesPlayed(0), searches(0), busyReplies(0) {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+
+    ~GameServer() {
+        ai.stop();
+        for (Connection& c : connections) closeFds(c);
+        if (stdoutFlags >= 0) fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags);
+        if (listenFd >= 0) { close(listenFd); unlink(opt.socketPath.c_str()); }
+        if (wakePipe[0] >= 0) { close(wakePipe[0]); close(wakePipe[1]); }
+    }
+
+    // Serves until stdin ends (stdio mode) or a client sends "shutdown".
+    // Returns false if the socket or pipe could not be set up.
+    bool run() {
+        signal(SIGPIPE, SIG_IGN);
+        if (pipe(wakePipe) != 0) { std::cerr << "pipe: " << strerror(errno) << "\n"; return false; }
+        setNonBlocking(wakePipe[0]);
+        setNonBlocking(wakePipe[1]);
+        if (opt.socketPath.empty()) {
+            // Non-blocking like a socket, so a slow reader holds up only its
+            // own replies; the shell gets the old flags back on exit
+            stdoutFlags = fcntl(STDOUT_FILENO, F_GETFL);
+            if (stdoutFlags >= 0) fcntl(STDOUT_FILENO, F_SETFL, stdoutFlags | O_NONBLOCK);
+            addConnection(STDIN_FILENO, STDOUT_FILENO);
+        }
+        else if (!listenOn(opt.socketPath)) return false;
+        ai.start(wakePipe[1]);
+        std::cerr << "serving " << pool.capacity() << " sessions with " << ai.threadCount() << " AI worker(s)"
+            << (opt.socketPath.empty() ? std::string(" on stdin/stdout") : " on " + opt.socketPath) << "\n";
+
+        std::vector<pollfd> fds;
+        std::vector<int> fdOwner;       // connection index per entry, -1 for the pipe and listener
+        std::vector<AiResult> results;
+        char buffer[65536];
+        while (running) {
+            fds.clear();
+            fdOwner.clear();
+            fds.push_back({ wakePipe[0], POLLIN, 0 });
+            fdOwner.push_back(-1);
+            if (listenFd >= 0) { fds.push_back({ listenFd, POLLIN, 0 }); fdOwner.push_back(-1); }
+            for (size_t i = 0;i < connections.size();i++) {
+                Connection& c = connections[i];
+                if (c.in < 0) continue;
+                bool pending = c.sent < c.output.size();
+                short events = 0;
+                if (!c.inputEnded && c.output.size() - c.sent < OutputLimit) events |= POLLIN;
+                if (pending && c.out == c.in) events |= POLLOUT;
+                // An ended input still reports POLLHUP whatever the events,
+                // and would wake the loop on every pass until retire()
+                if (!c.inputEnded || events) { fds.push_back({ c.in, events, 0 }); fdOwner.push_back((int)i); }
+                // stdout gets its own entry; the flush below does the writing
+                if (pending && c.out != c.in) { fds.push_back({ c.out, POLLOUT, 0 }); fdOwner.push_back((int)i); }
+            }
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "poll: " << strerror(errno) << "\n";
+                return false;
+            }
+
+            if (fds[0].revents) {
+                while (read(wakePipe[0], buffer, sizeof(buffer)) > 0) {}
+                ai.collect(results);
+                for (const AiResult& r : results) finishSearch(r);
+            }
+            if (listenFd >= 0 && fds[1].revents) acceptClients();
+            for (size_t i = 0;i < fds.size();i++) {
+                if (fdOwner[i] < 0 || !fds[i].revents) continue;
+                Connection& c = connections[fdOwner[i]];
+                if (fds[i].fd == c.in && !c.inputEnded && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    ssize_t n = read(c.in, buffer, sizeof(buffer));
+                    if (n > 0) c.input.append(buffer, (size_t)n);
+                    else if (n == 0 || (errno != EAGAIN && errno != EINTR)) c.inputEnded = true;
+                }
+            }
+            // Lines held back by a full output buffer are taken up again
+            // as soon as the client has read enough
+            for (size_t i = 0;i < connections.size();i++) {
+                if (connections[i].in < 0) continue;
+                flush(connections[i]);
+                handleInput((int)i);
+                flush(connections[i]);
+                retire((int)i);
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Connection {
+        int in, out;                // the same socket, or stdin and stdout
+        std::string input, output;
+        size_t sent;                // bytes of output already written
+        int thinking;               // its sessions with a search in flight
+        bool inputEnded;            // end of input, a read error or "quit"
+    };
+    static constexpr size_t OutputLimit = 1 << 20;     // unread replies before a client stops being read
+    static constexpr size_t MaxLine = 4096;
+
+    ServerOptions opt;
+    SessionPool pool;
+    AiWorkers ai;
+    std::vector<Connection> connections;    // closed entries are reused
+    int listenFd;
+    int stdoutFlags;                // to restore in stdio mode, -1 otherwise
+    int wakePipe[2];
+    bool running;
+    uint64_t movesPlayed, searches, busyReplies;
+
+    static void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    static void closeFds(Connection& c) {
+        if (c.in < 0) return;
+        if (c.in != STDIN_FILENO) close(c.in);
+        c.in = c.out = -1;
+    }
+
+    bool listenOn(const std::string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) { std::cerr << path << ": socket path too long\n"; return false; }
+        memcpy(addr.sun_path, path.c_str(), path.size());
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 128) != 0) {
+            std::cerr << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        setNonBlocking(listenFd);
+        return true;
+    }
+
+    void acceptClients() {
+        int fd;
+        while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) {
+            setNonBlocking(fd);
+            addConnection(fd, fd);
+        }
+    }
+
+    void addConnection(int in, int out) {
+        Connection c{ in, out, std::string(), std::string(), 0, 0, false };
+        for (Connection& old : connections) {
+            if (old.in < 0) { old = std::move(c); return; }
+        }
+        connections.push_back(std::move(c));
+    }
+
+    // Closes a connection once its input has ended, its searches are back
+    // and its replies are written; in stdio mode that ends the server.
+    void retire(int index) {
+        Connection& c = connections[index];
+        if (c.in < 0 || !c.inputEnded || c.thinking > 0 || c.sent < c.output.size()) return;
+        for (size_t s = 0;s < pool.capacity();s++) {
+            if (pool.at((uint32_t)s).owner == index) pool.release(&pool.at((uint32_t)s));
+        }
+        closeFds(c);
+        c.input.clear();
+        c.output.clear();
+        c.sent = 0;
+        if (opt.socketPath.empty()) running = false;
+    }
+
+    void flush(Connection& c) {
+        while (c.in >= 0 && c.sent < c.output.size()) {
+            ssize_t n = write(c.out, c.output.data() + c.sent, c.output.size() - c.sent);
+            if (n > 0) { c.sent += (size_t)n; continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno != EAGAIN) {
+                // The client has gone: drop what it will never read
+                c.inputEnded = true;
+                c.sent = c.output.size();
+            }
+            break;
+        }
+        if (c.sent == c.output.size()) { c.output.clear(); c.sent = 0; }
+    }
+
+    // Complete lines, until the connection's unread replies pass the limit.
+    void handleInput(int index) {
+        Connection& c = connections[index];
+        size_t at = 0, end;
+        while (c.output.size() - c.sent < OutputLimit && (end = c.input.find('\n', at)) != std::string::npos) {
+            std::string_view line(c.input.data() + at, end - at);
+            at = end + 1;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (!command(index, line)) break;
+        }
+        c.input.erase(0, at);
+        if (c.input.size() > MaxLine && c.input.find('\n') == std::string::npos) {
+            reply(c, "error - line too long");
+            c.inputEnded = true;
+        }
+        if (c.inputEnded) c.input.clear();
+    }
+
+    static void reply(Connection& c, const std::string& line) {
+        c.output += line;
+        c.output += '\n';
+    }
+
+    static int splitWords(std::string_view line, std::string_view words[], int maxWords) {
+        int n = 0;
+        size_t i = 0;
+        while (n < maxWords) {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) i++;
+            if (i == line.size()) break;
+            size_t j = i;
+            while (j < line.size() && line[j] != ' ' && line[j] != '\t') j++;
+            words[n++] = line.substr(i, j - i);
+            i = j;
+        }
+        return n;
+    }
+
+    static bool parseNumber(std::string_view s, uint64_t& out) {
+        if (s.empty() || s.size() > 18) return false;
+        out = 0;
+        for (char ch : s) {
+            if (ch < '0' || ch > '9') return false;
+            out = out * 10 + uint64_t(ch - '0');
+        }
+        return true;
+    }
+
+    // The session named by words[1] if this connection owns it; replies
+    // with an error otherwise.
+    SessionBoard* session(int index, std::string_view words[], int count) {
+        uint64_t id;
+        if (count < 2 || !parseNumber(words[1], id)) { reply(connections[index], "error - missing session id"); return nullptr; }
+        SessionBoard* b = pool.find(id);
+        if (!b || b->owner != index || b->closing) { reply(connections[index], "error " + std::string(words[1]) + " no such session"); return nullptr; }
+        return b;
+    }
+
+    // False when the connection is done ("quit").
+    bool command(int index, std::string_view line) {
+        std::string_view words[16];
+        int count = splitWords(line, words, 16);
+        if (count == 0) return true;
+        Connection& c = connections[index];
+        std::string_view cmd = words[0];
+
+        if (cmd == "new") {
+            Position start;
+            if (count >= 2 && words[1] == "fen") {
+                if (count < 3 || !start.setFen(std::string(line.substr(words[2].data() - line.data())))) {
+                    reply(c, "error - invalid fen");
+                    return true;
+                }
+            }
+            else start.setStartPosition();
+            SessionBoard* b = pool.acquire();
+            if (!b) { reply(c, "error - server full"); return true; }
+            b->reset(start, index);
+            reply(c, "new " + std::to_string(pool.id(b)));
+        }
+        else if (cmd == "move") {
+            SessionBoard* b = session(index, words, count);
+            if (!b) return true;
+            std::string id(words[1]);
+            if (b->thinking) { reply(c, "error " + id + " thinking"); return true; }
+            if (b->gameOver()) { reply(c, "error " + id + " game over"); return true; }
+            Move m = count >= 3 ? moveFromUci(b->pos, std::string(words[2])) : MOVE_NONE;
+            if (m == MOVE_NONE) { reply(c, "error " + id + " illegal move"); return true; }
+            b->play(m);
+            movesPlayed++;
+            reply(c, "moved " + id + " " + moveToUci(m) + " " + sessionStatusName(b->status()));
+        }
+        else if (cmd == "go") {
+            SessionBoard* b = session(index, words, count);
+            if (!b) return true;
+            std::string id(words[1]);
+            if (b->thinking) { reply(c, "error " + id + " thinking"); return true; }
+            if (b->gameOver()) { reply(c, "error " + id + " game over"); return true; }
+            AiJob job;
+            job.slot = pool.slot(b);
+            bool depthGiven = false;
+            for (int i = 2;i + 1 < count;i += 2) {
+                uint64_t v;
+                if (!parseNumber(words[i + 1], v)) continue;
+                if (words[i] == "depth") { job.limits.depth = (int)std::min<uint64_t>(std::max<uint64_t>(v, 1), MAX_PLY - 1); depthGiven = true; }
+                else if (words[i] == "movetime") job.limits.movetimeMs = (int64_t)v;
+                else if (words[i] == "nodes") job.limits.nodes = v;
+            }
+            // A time or node limit alone searches as deep as it allows
+            if (!depthGiven && !job.limits.movetimeMs && !job.limits.nodes) job.limits.depth = opt.depth;
+            // No request holds a worker longer than the server allows
+            if (opt.maxMovetimeMs > 0 && (!job.limits.movetimeMs || job.limits.movetimeMs > opt.maxMovetimeMs))
+                job.limits.movetimeMs = opt.maxMovetimeMs;
+            if (opt.maxNodes > 0 && (!job.limits.nodes || job.limits.nodes > opt.maxNodes)) job.limits.nodes = opt.maxNodes;
+            if (!ai.submit(job)) { busyReplies++; reply(c, "busy " + id); return true; }
+            b->thinking = true;
+            c.thinking++;
+            searches++;
+        }
+        else if (cmd == "fen") {
+            SessionBoard* b = session(index, words, count);
+            if (b) reply(c, "fen " + std::string(words[1]) + " " + b->pos.fen());
+        }
+        else if (cmd == "close") {
+            SessionBoard* b = session(index, words, count);
+            if (!b) return true;
+            if (b->thinking) b->closing = true;
+            else pool.release(b);
+            reply(c, "closed " + std::string(words[1]));
+        }
+        else if (cmd == "stats") {
+            reply(c, "stats sessions " + std::to_string(pool.inUse()) + "/" + std::to_string(pool.capacity())
+                + " queued " + std::to_string(ai.queueLength()) + "/" + std::to_string(ai.queueCapacity())
+                + " workers " + std::to_string(ai.threadCount()) + " moves " + std::to_string(movesPlayed)
+                + " searches " + std::to_string(searches) + " busy " + std::to_string(busyReplies));
+        }
+        else if (cmd == "quit") {
+            c.inputEnded = true;
+            return false;
+        }
+        else if (cmd == "shutdown") {
+            running = false;
+            return false;
+        }
+        else reply(c, "error - unknown command " + std::string(cmd));
+        return true;
+    }
+
+    void finishSearch(const AiResult& r) {
+        SessionBoard& b = pool.at(r.slot);
+        Connection& c = connections[b.owner];
+        b.thinking = false;
+        c.thinking--;
+        if (b.closing) { pool.release(&b); return; }
+        std::string id = std::to_string(pool.id(&b));
+        if (r.move == MOVE_NONE) { reply(c, "error " + id + " no move"); return; }
+        b.play(r.move);
+        movesPlayed++;
+        reply(c, "bestmove " + id + " " + moveToUci(r.move) + " " + sessionStatusName(b.status()));
+    }
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "search.h"
+
+// ======================= Lazy SMP =======================
+// N searchers run the same root on their own threads and share one
+// transposition table; what one thread stores, the others cut off on.
+// Thread 0 drives time control and reporting. When it finishes, the
+// helpers are told to stop and the deepest completed result wins.
+// Helper threads are started once by setThreads() and sleep between
+// searches, so a move costs no thread creation or heap allocation.
+class SmpSearch {
+public:
+    std::function<void(const SearchInfo&)> onIteration;
+
+    SmpSearch() : tt(nullptr), job(0), running(0), quitting(false), root(nullptr), gameKeys(nullptr) { setThreads(1); }
+    ~SmpSearch() { stopHelpers(); }
+
+    void setThreads(int n) {
+        if (n < 1) n = 1;
+        stopHelpers();
+        workers.clear();
+        for (int i = 0;i < n;i++) {
+            workers.emplace_back(new Searcher());
+            workers.back()->threadIndex = i;
+            workers.back()->tt = tt;
+        }
+        results.assign(n, SearchInfo());
+        // Report the main thread's iterations with every thread's nodes
+        workers[0]->onIteration = [this](const SearchInfo& info) {
+            if (!onIteration) return;
+            SearchInfo total = info;
+            total.nodes = info.nodes + helperNodes();
+            onIteration(total);
+        };
+        quitting = false;
+        for (int i = 1;i < n;i++) helpers.emplace_back(&SmpSearch::helperLoop, this, i, job);
+    }
+
+    int threadCount() const { return (int)workers.size(); }
+
+    void setTable(TranspositionTable* table) {
+        tt = table;
+        for (auto& w : workers) w->tt = table;
+    }
+
+    // Safe to call from any thread while think() runs.
+    void stop() {
+        for (auto& w : workers) w->stopRequested = true;
+    }
+
+    SearchInfo think(const Position& rootPos, const std::vector<uint64_t>& keys, const SearchLimits& searchLimits) {
+        if (tt) tt->newSearch();
+        for (auto& w : workers) w->stopRequested = false;
+
+        // Wake the helpers on this root
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            root = &rootPos;
+            gameKeys = &keys;
+            limits = searchLimits;
+            running = (int)workers.size() - 1;
+            job++;
+        }
+        wake.notify_all();
+
+        results[0] = workers[0]->think(rootPos, keys, searchLimits);
+
+        for (size_t i = 1;i < workers.size();i++) workers[i]->stopRequested = true;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            done.wait(guard, [this]() { return running == 0; });
+        }
+
+        SearchInfo best = results[0];
+        for (size_t i = 1;i < results.size();i++) {
+            if (results[i].depth > best.depth && !results[i].pv.empty()) best = results[i];
+        }
+        best.nodes = 0;
+        for (const SearchInfo& r : results) best.nodes += r.nodes;
+        best.elapsedMs = results[0].elapsedMs;
+        best.ttProbes = best.ttHits = best.pawnProbes = best.pawnHits = 0;
+        for (const SearchInfo& r : results) {
+            best.ttProbes += r.ttProbes; best.ttHits += r.ttHits;
+            best.pawnProbes += r.pawnProbes; best.pawnHits += r.pawnHits;
+        }
+        return best;
+    }
+
+private:
+    std::vector<std::unique_ptr<Searcher>> workers;
+    std::vector<SearchInfo> results;    // one per worker, reused by every search
+    std::vector<std::thread> helpers;   // threads for workers 1..N-1
+    TranspositionTable* tt;
+
+    // Job hand-off to the helpers, guarded by `lock`
+    std::mutex lock;
+    std::condition_variable wake, done;
+    uint64_t job;                   // bumped once per think()
+    int running;                    // helpers still searching the current job
+    bool quitting;
+    const Position* root;
+    const std::vector<uint64_t>* gameKeys;
+    SearchLimits limits;
+
+    // seen: the last job before this thread existed, so it waits for the next
+    void helperLoop(int index, uint64_t seen) {
+        for (;;) {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&]() { return quitting || job != seen; });
+            if (quitting) return;
+            seen = job;
+            guard.unlock();
+
+            results[index] = workers[index]->think(*root, *gameKeys, limits);
+
+            guard.lock();
+            if (--running == 0) done.notify_all();
+        }
+    }
+
+    void stopHelpers() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            quitting = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : helpers) t.join();
+        helpers.clear();
+    }
+
+    uint64_t helperNodes() const {
+        uint64_t n = 0;
+        for (size_t i = 1;i < workers.size();i++) n += workers[i]->publishedNodes.load(std::memory_order_relaxed);
+        return n;
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// ======================= Instrumentation =======================
+// Call counts and time spent in the hot paths, for builds configured with
+// -DCHESS_STATS=ON (which defines STATS). Otherwise STATS_SCOPE expands to
+// nothing and the engine carries no cost. Times come from the CPU's time
+// stamp counter where there is one (nanoseconds elsewhere) and include
+// nested scopes: inCheck's time includes its isAttacked call.
+//
+// Each thread counts into its own cache-line-aligned block that only it
+// writes, so counting takes no locks and no shared cache lines. A dump
+// sums the live blocks with the totals of threads that have exited.
+enum StatId {
+    STAT_MOVEGEN,       // generate<Type>(): every legal move list
+    STAT_IS_LEGAL,      // isLegal(): pins, king moves and en passant
+    STAT_IN_CHECK,      // Position::inCheck()
+    STAT_IS_ATTACKED,   // Position::isAttacked()
+    STAT_MAKE,          // Position::makeMove()
+    STAT_UNMAKE,        // Position::unmakeMove()
+    STAT_SEARCH,        // Searcher::think(), per search thread
+    STAT_AI_MOVE,       // the game's whole AI move choice: book, tablebase, search
+    STAT_COUNT
+};
+
+inline const char* statName(int id) {
+    static const char* names[STAT_COUNT] = { "movegen", "isLegal", "inCheck", "isAttacked",
+        "makeMove", "unmakeMove", "search", "aiMove" };
+    return names[id];
+}
+
+#if defined(STATS)
+const bool StatsEnabled = true;
+#else
+const bool StatsEnabled = false;
+#endif
+
+inline uint64_t statsTimestamp() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline const char* statsTimerUnit() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+// One thread's counters. A single writer means a relaxed load and store
+// is enough; the atomics only make reads from the dumping thread safe.
+struct alignas(64) StatCounters {
+    std::atomic<uint64_t> calls[STAT_COUNT];
+    std::atomic<uint64_t> ticks[STAT_COUNT];
+
+    StatCounters() {
+        for (int i = 0;i < STAT_COUNT;i++) { calls[i] = 0; ticks[i] = 0; }
+    }
+
+    void add(int id, uint64_t elapsed) {
+        calls[id].store(calls[id].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ticks[id].store(ticks[id].load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    }
+};
+
+struct StatTotals {
+    uint64_t calls[STAT_COUNT];
+    uint64_t ticks[STAT_COUNT];
+    int threads;                // threads that have counted anything
+};
+
+// The lock is only taken when a thread starts or ends counting, and for a dump.
+class StatsRegistry {
+public:
+    StatsRegistry() : retiredThreads(0) {
+        for (int i = 0;i < STAT_COUNT;i++) retiredCalls[i] = retiredTicks[i] = 0;
+    }
+
+    void attach(StatCounters* c) {
+        std::lock_guard<std::mutex> guard(lock);
+        live.push_back(c);
+    }
+
+    void detach(StatCounters* c) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0;i < STAT_COUNT;i++) {
+            retiredCalls[i] += c->calls[i].load(std::memory_order_relaxed);
+            retiredTicks[i] += c->ticks[i].load(std::memory_order_relaxed);
+        }
+        retiredThreads++;
+        for (size_t i = 0;i < live.size();i++) {
+            if (live[i] == c) { live.erase(live.begin() + i); break; }
+        }
+    }
+
+    StatTotals totals() {
+        std::lock_guard<std::mutex> guard(lock);
+        StatTotals t;
+        for (int i = 0;i < STAT_COUNT;i++) { t.calls[i] = retiredCalls[i]; t.ticks[i] = retiredTicks[i]; }
+        for (StatCounters* c : live) {
+            for (int i = 0;i < STAT_COUNT;i++) {
+                t.calls[i] += c->calls[i].load(std::memory_order_relaxed);
+                t.ticks[i] += c->ticks[i].load(std::memory_order_relaxed);
+            }
+        }
+        t.threads = retiredThreads + (int)live.size();
+        return t;
+    }
+
+private:
+    std::mutex lock;
+    std::vector<StatCounters*> live;
+    uint64_t retiredCalls[STAT_COUNT], retiredTicks[STAT_COUNT];
+    int retiredThreads;
+};
+
+inline StatsRegistry& statsRegistry() {
+    static StatsRegistry registry;
+    return registry;
+}
+
+struct ThreadStats {
+    StatCounters counters;
+    ThreadStats() { statsRegistry().attach(&counters); }
+    ~ThreadStats() { statsRegistry().detach(&counters); }
+};
+
+inline StatCounters& threadStats() {
+    thread_local ThreadStats stats;
+    return stats.counters;
+}
+
+// Counts one call and its duration into the current thread's block.
+class StatsScope {
+public:
+    explicit StatsScope(StatId id) : id(id), start(statsTimestamp()) {}
+    ~StatsScope() { threadStats().add(id, statsTimestamp() - start); }
+
+private:
+    StatId id;
+    uint64_t start;
+};
+
+#if defined(STATS)
+#define STATS_SCOPE(id) StatsScope statsScope(id)
+#else
+#define STATS_SCOPE(id) ((void)0)
+#endif
+
+// ======================= Stats Dump =======================
+// The build is part of every dump so results from different builds can
+// be told apart when tracking regressions.
+inline std::string statsBuild() {
+    std::string s;
+#if defined(__clang__)
+    s = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    s = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    s = "msvc " + std::to_string(_MSC_VER);
+#endif
+#if defined(USE_PEXT)
+    s += " pext";
+#endif
+#if defined(HASH_DEBUG)
+    s += " hash-debug";
+#endif
+    return s;
+}
+
+inline void writeStatsJson(std::ostream& out) {
+    StatTotals t = statsRegistry().totals();
+    out << "{\n  \"enabled\": " << (StatsEnabled ? "true" : "false") << ",\n"
+        << "  \"build\": \"" << statsBuild() << "\",\n"
+        << "  \"timer\": \"" << statsTimerUnit() << "\",\n"
+        << "  \"threads\": " << t.threads << ",\n"
+        << "  \"counters\": {\n";
+    for (int i = 0;i < STAT_COUNT;i++) {
+        out << "    \"" << statName(i) << "\": { \"calls\": " << t.calls[i] << ", \"ticks\": " << t.ticks[i]
+            << ", \"ticksPerCall\": " << (t.calls[i] ? (double)t.ticks[i] / t.calls[i] : 0.0) << " }"
+            << (i + 1 < STAT_COUNT ? "," : "") << "\n";
+    }
+    out << "  }\n}\n";
+}
+
+inline void writeStatsCsv(std::ostream& out) {
+    StatTotals t = statsRegistry().totals();
+    out << "counter,calls,ticks,ticks_per_call,timer,build\n";
+    for (int i = 0;i < STAT_COUNT;i++) {
+        out << statName(i) << "," << t.calls[i] << "," << t.ticks[i] << ","
+            << (t.calls[i] ? (double)t.ticks[i] / t.calls[i] : 0.0) << "," << statsTimerUnit()
+            << ",\"" << statsBuild() << "\"\n";
+    }
+}
+
+// CSV when the name ends in ".csv", JSON otherwise.
+inline bool writeStatsFile(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) writeStatsCsv(out);
+    else writeStatsJson(out);
+    return (bool)out;
+}
@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mmap.h"
+#include "search.h"
+
+// ======================= Endgame Tablebases =======================
+// Distance-to-mate tables for every material set of up to four pieces,
+// kings included, built offline by tbgen. One file per set ("KQKR.ctb",
+// the stronger side first) holds one entry per (side to move, squares):
+//   header   magic "CHSTB001", version, bits per entry, entry count
+//   entries  bit-packed codes: 0 for a draw, otherwise 1 + plies to mate,
+//            a win for the side to move when that distance is odd
+// Positions with castling rights are not covered, and neither are sets
+// with pawns on both sides, whose en passant captures the index cannot
+// express. The fifty-move rule is ignored.
+const int TB_MAX_PIECES = 4;
+const char TablebaseMagic[8] = { 'C', 'H', 'S', 'T', 'B', '0', '0', '1' };
+const uint32_t TablebaseVersion = 1;
+
+struct TablebaseHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bits;              // bits per entry
+    uint64_t entries;
+    uint32_t maxPlies;          // longest mate in the table
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TablebaseHeader) == 32, "TablebaseHeader must stay 32 bytes");
+
+// Pieces in index order: white king, black king, then the others as the
+// name lists them. White is always the side named first.
+struct TbMaterial {
+    std::string name;
+    Piece pieces[TB_MAX_PIECES];
+    int count;
+};
+
+// One side's pieces as letters, strongest first: "KRB".
+inline std::string tbSideName(const int counts[6]) {
+    std::string s = "K";
+    for (int t = QUEEN;t >= PAWN;t--) s.append(counts[t], "PNBRQK"[t]);
+    return s;
+}
+
+inline int tbSideStrength(const std::string& side) {
+    int v = 0;
+    for (char ch : side) v += ch == 'K' ? 0 : PieceValue[typeOf(pieceFromSymbol(ch))];
+    return v;
+}
+
+// Table name for two sides' pieces; flip is set when black holds the
+// stronger side, so colours must be swapped to use the table.
+inline std::string tbCanonicalName(const std::string& white, const std::string& black, bool& flip) {
+    flip = black.size() > white.size() || (black.size() == white.size() && tbSideStrength(black) > tbSideStrength(white));
+    return flip ? black + white : white + black;
+}
+
+inline std::string tbMaterialName(const Position& pos, bool& flip) {
+    int counts[2][6];
+    for (int c = WHITE;c <= BLACK;c++)
+        for (int t = PAWN;t <= KING;t++) counts[c][t] = popCount(pos.pieces(Color(c), PieceType(t)));
+    return tbCanonicalName(tbSideName(counts[WHITE]), tbSideName(counts[BLACK]), flip);
+}
+
+// False for names that are not a supported table.
+inline bool parseMaterial(const std::string& name, TbMaterial& out) {
+    size_t second = name.find('K', 1);
+    if (name.empty() || name[0] != 'K' || second == std::string::npos || name.size() > TB_MAX_PIECES || name.size() < 3) return false;
+    out.name = name;
+    out.count = 0;
+    out.pieces[out.count++] = W_KING;
+    out.pieces[out.count++] = B_KING;
+    int counts[2][6] = {};
+    for (size_t i = 1;i < name.size();i++) {
+        if (i == second) continue;
+        Piece p = pieceFromSymbol(name[i]);
+        if (p == NO_PIECE || typeOf(p) == KING) return false;
+        Color c = i < second ? WHITE : BLACK;
+        counts[c][typeOf(p)]++;
+        out.pieces[out.count++] = makePiece(c, typeOf(p));
+    }
+    if (counts[WHITE][PAWN] && counts[BLACK][PAWN]) return false;
+    bool flip;
+    return tbCanonicalName(tbSideName(counts[WHITE]), tbSideName(counts[BLACK]), flip) == name && !flip;
+}
+
+inline uint64_t tbEntries(const TbMaterial& m) {
+    return 2ULL * 32 << (6 * (m.count - 1));
+}
+
+// The white king is mirrored onto files a-d, halving the table; without
+// castling rights that mirror never changes a result. Two identical
+// pieces are indexed in ascending square order.
+inline uint64_t tbIndex(const TbMaterial& m, Color stm, const int squares[TB_MAX_PIECES]) {
+    int sq[TB_MAX_PIECES] = {};
+    int mirror = colOf(squares[0]) > 3 ? 7 : 0;
+    for (int i = 0;i < m.count;i++) sq[i] = squares[i] ^ mirror;
+    if (m.count == 4 && m.pieces[2] == m.pieces[3] && sq[2] > sq[3]) std::swap(sq[2], sq[3]);
+    uint64_t idx = (uint64_t)stm * 32 + rowOf(sq[0]) * 4 + colOf(sq[0]);
+    for (int i = 1;i < m.count;i++) idx = idx * 64 + sq[i];
+    return idx;
+}
+
+inline Color tbDecode(const TbMaterial& m, uint64_t idx, int sq[TB_MAX_PIECES]) {
+    for (int i = m.count - 1;i >= 1;i--) { sq[i] = int(idx % 64); idx /= 64; }
+    int k = int(idx % 32);
+    sq[0] = makeSquare(k / 4, k % 4);
+    return Color(idx / 32);
+}
+
+// Result for the side to move.
+struct TbEntry {
+    int wdl;                    // 1 win, 0 draw, -1 loss
+    int plies;                  // to mate, 0 when already mated or drawn
+};
+
+inline TbEntry tbEntryFromCode(unsigned code) {
+    if (code == 0) return { 0, 0 };
+    int plies = int(code) - 1;
+    return { plies & 1 ? 1 : -1, plies };
+}
+
+// As a search score: mates inside MATE_BOUND, so scoreToString prints "mate N".
+inline int tbScore(const TbEntry& e) {
+    return e.wdl > 0 ? MATE_SCORE - e.plies : e.wdl < 0 ? -MATE_SCORE + e.plies : 0;
+}
+
+// ======================= Tablebase Reader =======================
+// Maps table files on first use and keeps at most maxOpen of them mapped,
+// unmapping the least recently used. The mapped bit-packed data is the
+// whole cache: a probe reads one entry in place, and the OS keeps the
+// pages in use resident. Not thread-safe; give each thread its own.
+class Tablebases {
+public:
+    uint64_t probes, hits;
+
+    explicit Tablebases(size_t maxOpen = 8) : probes(0), hits(0), maxOpen(maxOpen ? maxOpen : 1), useCount(0), available(0) {}
+
+    // Directory holding the .ctb files; returns how many tables it has.
+    int init(const std::string& directory) {
+        dir = directory;
+        slots.clear();
+        missing.clear();
+        int found = 0;
+        for (const std::string& name : tbAllTables()) {
+            FILE* f = fopen(path(name).c_str(), "rb");
+            if (f) { found++; fclose(f); }
+            else missing.push_back(name);
+        }
+        available = found;
+        return found;
+    }
+
+    int tableCount() const { return available; }
+
+    // False when no table covers the position.
+    bool probe(const Position& pos, TbEntry& out) {
+        Bitboard occ = pos.occupied();
+        if (pos.castling || popCount(occ) > TB_MAX_PIECES) return false;
+        probes++;
+        if (popCount(occ) == 2) { out = { 0, 0 }; hits++; return true; }
+        bool flip;
+        std::string name = tbMaterialName(pos, flip);
+        Slot* table = open(name);
+        if (!table) return false;
+
+        int sq[TB_MAX_PIECES] = {};
+        for (int i = 0;i < table->material.count;i++) {
+            Piece p = table->material.pieces[i];
+            Bitboard b = pos.pieces(flip ? makePiece(!colorOf(p), typeOf(p)) : p);
+            if (i > 0 && p == table->material.pieces[i - 1]) b &= b - 1;
+            sq[i] = lsb(b) ^ (flip ? 56 : 0);
+        }
+        uint64_t idx = tbIndex(table->material, flip ? !pos.sideToMove : pos.sideToMove, sq);
+        out = tbEntryFromCode(table->code(idx));
+        hits++;
+        return true;
+    }
+
+    // The move keeping the best result: the fastest win, else a draw,
+    // else the longest defence. MOVE_NONE when the position is not covered
+    // or has no legal moves.
+    Move bestMove(const Position& pos, TbEntry* result = nullptr) {
+        TbEntry here;
+        if (!probe(pos, here)) return MOVE_NONE;
+        MoveList moves;
+        generateLegal(pos, moves);
+        Move best = MOVE_NONE;
+        TbEntry bestEntry = { -2, 0 };
+        for (Move m : moves) {
+            TbEntry child;
+            if (!probe(pos.after(m), child)) return MOVE_NONE;
+            TbEntry e = { -child.wdl, child.wdl ? child.plies + 1 : 0 };
+            bool better = e.wdl != bestEntry.wdl ? e.wdl > bestEntry.wdl
+                        : e.wdl > 0 ? e.plies < bestEntry.plies : e.plies > bestEntry.plies;
+            if (better) { best = m; bestEntry = e; }
+        }
+        if (result) *result = best == MOVE_NONE ? here : bestEntry;
+        return best;
+    }
+
+    // Every supported set, in an order where each table's captures and
+    // promotions only lead to tables listed before it.
+    static std::vector<std::string> tbAllTables() {
+        static const char* sides[] = { "KQ", "KR", "KB", "KN", "KP" };
+        std::vector<std::string> names;
+        for (const char* s : sides) names.push_back(std::string(s) + "K");
+        for (int pawns = 0;pawns <= 2;pawns++) {
+            for (int i = 0;i < 5;i++) {
+                for (int j = i;j < 5;j++) {
+                    std::string twoPieces = std::string(sides[i]) + sides[j][1] + "K";
+                    std::string oneEach = std::string(sides[i]) + sides[j];
+                    for (const std::string& name : { twoPieces, oneEach }) {
+                        int p = int(std::count(name.begin(), name.end(), 'P'));
+                        TbMaterial m;
+                        if (p == pawns && parseMaterial(name, m)) names.push_back(name);
+                    }
+                }
+            }
+        }
+        return names;
+    }
+
+private:
+    struct Slot {
+        TbMaterial material;
+        MappedFile file;
+        const uint8_t* data;
+        uint32_t bits;
+        uint64_t lastUse;
+
+        unsigned code(uint64_t idx) const {
+            uint64_t bit = idx * bits, word;
+            memcpy(&word, data + bit / 8, sizeof(word));    // files carry 8 bytes of padding
+            return unsigned(word >> (bit & 7)) & ((1u << bits) - 1);
+        }
+    };
+
+    std::string dir;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::string> missing;   // names without a file, so a miss costs no open()
+    size_t maxOpen;
+    uint64_t useCount;
+    int available;
+
+    std::string path(const std::string& name) const { return dir + "/" + name + ".ctb"; }
+
+    Slot* open(const std::string& name) {
+        for (auto& s : slots) {
+            if (s->material.name == name) { s->lastUse = ++useCount; return s.get(); }
+        }
+        for (const std::string& m : missing) if (m == name) return nullptr;
+
+        std::unique_ptr<Slot> slot(new Slot());
+        TablebaseHeader h;
+        bool ok = parseMaterial(name, slot->material) && slot->file.open(path(name)) && slot->file.size() >= sizeof(h);
+        if (ok) {
+            memcpy(&h, slot->file.data(), sizeof(h));
+            ok = memcmp(h.magic, TablebaseMagic, sizeof(h.magic)) == 0 && h.version == TablebaseVersion
+                && h.bits >= 1 && h.bits <= 8 && h.entries == tbEntries(slot->material)
+                && slot->file.size() >= sizeof(h) + (h.entries * h.bits + 7) / 8 + 8;
+        }
+        if (!ok) { missing.push_back(name); return nullptr; }
+        slot->data = (const uint8_t*)slot->file.data() + sizeof(h);
+        slot->bits = h.bits;
+        slot->lastUse = ++useCount;
+
+        if (slots.size() >= maxOpen) {
+            size_t oldest = 0;
+            for (size_t i = 1;i < slots.size();i++) if (slots[i]->lastUse < slots[oldest]->lastUse) oldest = i;
+            slots.erase(slots.begin() + oldest);
+        }
+        slots.push_back(std::move(slot));
+        return slots.back().get();
+    }
+};
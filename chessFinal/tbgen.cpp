@@ -0,0 +1,310 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include "tablebase.h"
+using namespace std;
+
+// ======================= Retrograde Generator =======================
+// One table at a time, smallest material first, so captures and
+// promotions can be looked up in tables already written:
+//   1. Every index is decoded and its legal moves generated. Mates and
+//      stalemates are final; moves into other tables are resolved by
+//      probing them; the rest are counted.
+//   2. Level by level (plies to mate), each position resolved at level n
+//      is unmoved to its predecessors. Behind a loss, a predecessor wins
+//      at n + 1; behind a win, it loses a move, and once every move is
+//      known to lose it is lost at the longest of them.
+// Whatever is never resolved is a draw.
+const uint8_t TB_INVALID = 1, TB_RESOLVED = 2, TB_HAS_DRAW = 4;
+const uint8_t TB_NONE = 0xFF;
+const int TB_MAX_LEVEL = 254;       // codes are 1 + plies and fit a byte
+
+class TableGenerator {
+public:
+    TableGenerator(const TbMaterial& material, Tablebases& subtables) : m(material), tb(subtables) {}
+
+    // False if a table it depends on is missing or a mate is too long.
+    bool generate() {
+        uint64_t n = tbEntries(m);
+        code.assign(n, 0);
+        flags.assign(n, 0);
+        remaining.assign(n, 0);
+        winAt.assign(n, TB_NONE);
+        lossAt.assign(n, 0);
+        maxLevel = 0;
+        if (!initialPass()) return false;
+        for (int level = 0;level <= maxLevel;level++) {
+            if (level > TB_MAX_LEVEL) return false;
+            resolveLevel(level);
+            propagateLevel(level);
+        }
+        return true;
+    }
+
+    // Header, bit-packed codes, then 8 bytes of padding for the reader's
+    // unaligned 64-bit loads.
+    bool write(const string& path, uint64_t& bytes, int& longest) const {
+        unsigned maxCode = 1;
+        for (uint8_t c : code) if (c > maxCode) maxCode = c;
+        uint32_t bits = 1;
+        while ((1u << bits) <= maxCode) bits++;
+        vector<uint8_t> packed((code.size() * bits + 7) / 8 + 8, 0);
+        for (uint64_t i = 0;i < code.size();i++) {
+            uint64_t bit = i * bits;
+            unsigned v = code[i] << (bit & 7);
+            for (int b = 0;v;b++, v >>= 8) packed[bit / 8 + b] |= uint8_t(v);
+        }
+        TablebaseHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, TablebaseMagic, sizeof(h.magic));
+        h.version = TablebaseVersion;
+        h.bits = bits;
+        h.entries = code.size();
+        h.maxPlies = maxCode - 1;
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        fwrite(&h, 1, sizeof(h), file);
+        fwrite(packed.data(), 1, packed.size(), file);
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        bytes = sizeof(h) + packed.size();
+        longest = int(maxCode - 1);
+        return ok;
+    }
+
+    // Wins, draws and losses for the side to move over legal positions.
+    void counts(uint64_t& wins, uint64_t& draws, uint64_t& losses) const {
+        wins = draws = losses = 0;
+        for (uint64_t i = 0;i < code.size();i++) {
+            if (flags[i] & TB_INVALID) continue;
+            TbEntry e = tbEntryFromCode(code[i]);
+            if (e.wdl > 0) wins++;
+            else if (e.wdl < 0) losses++;
+            else draws++;
+        }
+    }
+
+private:
+    const TbMaterial& m;
+    Tablebases& tb;
+    vector<uint8_t> code, flags, remaining, winAt, lossAt;
+    int maxLevel;
+
+    Bitboard occupancy(const int sq[TB_MAX_PIECES]) const {
+        Bitboard occ = 0;
+        for (int i = 0;i < m.count;i++) occ |= squareBB(sq[i]);
+        return occ;
+    }
+
+    bool attacked(const int sq[TB_MAX_PIECES], int target, Color by) const {
+        Bitboard occ = occupancy(sq);
+        for (int i = 0;i < m.count;i++) {
+            Piece p = m.pieces[i];
+            if (colorOf(p) == by && (attacksFrom(typeOf(p), by, sq[i], occ) & squareBB(target))) return true;
+        }
+        return false;
+    }
+
+    // Distinct squares, no pawn on a back rank, the side that just moved
+    // not in check, and the index's own canonical form.
+    bool isValid(uint64_t idx, const int sq[TB_MAX_PIECES], Color stm) const {
+        if (popCount(occupancy(sq)) != m.count || tbIndex(m, stm, sq) != idx) return false;
+        for (int i = 2;i < m.count;i++)
+            if (typeOf(m.pieces[i]) == PAWN && (rowOf(sq[i]) == 0 || rowOf(sq[i]) == 7)) return false;
+        return !attacked(sq, sq[!stm], stm);
+    }
+
+    Position makePosition(const int sq[TB_MAX_PIECES], Color stm) const {
+        Position pos;
+        pos.clear();
+        for (int i = 0;i < m.count;i++) pos.putPiece(m.pieces[i], sq[i]);
+        pos.sideToMove = stm;
+        pos.key = pos.computeKey();
+        pos.updateCheckInfo();
+        return pos;
+    }
+
+    void schedule(int level) {
+        if (level > maxLevel) maxLevel = level;
+    }
+
+    bool initialPass() {
+        int sq[TB_MAX_PIECES] = {};
+        for (uint64_t idx = 0;idx < code.size();idx++) {
+            Color stm = tbDecode(m, idx, sq);
+            if (!isValid(idx, sq, stm)) { flags[idx] = TB_INVALID; continue; }
+            Position pos = makePosition(sq, stm);
+            MoveList moves;
+            generateLegal(pos, moves);
+            if (moves.size() == 0) {
+                flags[idx] = TB_RESOLVED;
+                code[idx] = pos.inCheck(stm) ? 1 : 0;   // mated at level 0, or stalemate
+                continue;
+            }
+            int count = moves.size();
+            for (Move mv : moves) {
+                if (!isCapture(mv) && !isPromotion(mv)) continue;
+                TbEntry child;
+                if (!tb.probe(pos.after(mv), child)) {
+                    bool flip;
+                    cerr << m.name << ": needs the " << tbMaterialName(pos.after(mv), flip) << " table\n";
+                    return false;
+                }
+                if (child.wdl < 0) winAt[idx] = uint8_t(min<int>(winAt[idx], child.plies + 1));
+                else {
+                    count--;
+                    if (child.wdl == 0) flags[idx] |= TB_HAS_DRAW;
+                    else lossAt[idx] = uint8_t(max<int>(lossAt[idx], child.plies + 1));
+                }
+            }
+            remaining[idx] = uint8_t(count);
+            if (winAt[idx] != TB_NONE) schedule(winAt[idx]);
+            else if (count == 0 && !(flags[idx] & TB_HAS_DRAW)) schedule(lossAt[idx]);
+        }
+        return true;
+    }
+
+    // Positions whose result became certain at this level.
+    void resolveLevel(int level) {
+        for (uint64_t idx = 0;idx < code.size();idx++) {
+            if (flags[idx] & (TB_INVALID | TB_RESOLVED)) continue;
+            bool lost = remaining[idx] == 0 && !(flags[idx] & TB_HAS_DRAW) && lossAt[idx] == level;
+            if (winAt[idx] == level || lost) {
+                flags[idx] |= TB_RESOLVED;
+                code[idx] = uint8_t(level + 1);
+            }
+        }
+    }
+
+    // Unmoves every position resolved at this level.
+    void propagateLevel(int level) {
+        int sq[TB_MAX_PIECES] = {}, prev[TB_MAX_PIECES] = {};
+        for (uint64_t idx = 0;idx < code.size();idx++) {
+            if (!(flags[idx] & TB_RESOLVED) || code[idx] != level + 1) continue;
+            bool isLoss = (level & 1) == 0;
+            Color stm = tbDecode(m, idx, sq);
+            Color mover = !stm;
+            Bitboard occ = occupancy(sq);
+            for (int i = 0;i < m.count;i++) {
+                Piece p = m.pieces[i];
+                if (colorOf(p) != mover) continue;
+                for (Bitboard from = unmoveSquares(typeOf(p), mover, sq[i], occ);from;) {
+                    memcpy(prev, sq, sizeof(prev));
+                    prev[i] = popLsb(from);
+                    // The side to move now must not have been left in check
+                    if (attacked(prev, prev[stm], mover)) continue;
+                    uint64_t p2 = tbIndex(m, mover, prev);
+                    if (flags[p2] & (TB_INVALID | TB_RESOLVED)) continue;
+                    if (isLoss) {
+                        if (winAt[p2] > level + 1) winAt[p2] = uint8_t(level + 1);
+                        schedule(level + 1);
+                    }
+                    else {
+                        if (lossAt[p2] < level + 1) lossAt[p2] = uint8_t(level + 1);
+                        if (--remaining[p2] == 0 && !(flags[p2] & TB_HAS_DRAW) && winAt[p2] == TB_NONE) schedule(lossAt[p2]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Squares a piece now on `to` could have come from without capturing.
+    static Bitboard unmoveSquares(PieceType t, Color c, int to, Bitboard occ) {
+        if (t != PAWN) return attacksFrom(t, c, to, occ) & ~occ;
+        int back = c == WHITE ? 8 : -8;
+        int from = to + back;
+        if (from < 8 || from >= 56 || (occ & squareBB(from))) return 0;
+        Bitboard b = squareBB(from);
+        // A double push from the second rank
+        int startRow = c == WHITE ? 6 : 1;
+        if (rowOf(from + back) == startRow && !(occ & squareBB(from + back))) b |= squareBB(from + back);
+        return b;
+    }
+};
+
+// ======================= Build Order =======================
+// The requested tables with everything their captures and promotions
+// reach, in the dependency order of Tablebases::tbAllTables().
+vector<string> buildOrder(const vector<string>& wanted) {
+    vector<string> all = Tablebases::tbAllTables(), order;
+    vector<bool> needed(all.size(), false);
+    for (const string& w : wanted) {
+        for (size_t i = 0;i < all.size();i++) if (all[i] == w) needed[i] = true;
+    }
+    // Later tables only depend on earlier ones, so one backward sweep
+    // collects every dependency
+    for (size_t i = all.size();i-- > 0;) {
+        if (!needed[i]) continue;
+        string white = all[i].substr(0, all[i].find('K', 1)), black = all[i].substr(white.size());
+        for (int side = 0;side < 2;side++) {
+            string& s = side == 0 ? white : black;
+            for (size_t k = 1;k < s.size();k++) {
+                vector<string> variants = { s.substr(0, k) + s.substr(k + 1) };
+                if (s[k] == 'P') for (char promo : string("QRBN")) variants.push_back(s.substr(0, k) + promo + s.substr(k + 1));
+                for (string v : variants) {
+                    // Back to strongest-first letter order
+                    int counts[6] = {};
+                    for (size_t j = 1;j < v.size();j++) counts[typeOf(pieceFromSymbol(v[j]))]++;
+                    string w2 = side == 0 ? tbSideName(counts) : white, b2 = side == 1 ? tbSideName(counts) : black;
+                    bool flip;
+                    string dep = tbCanonicalName(w2, b2, flip);
+                    for (size_t j = 0;j < all.size();j++) if (all[j] == dep) needed[j] = true;
+                }
+            }
+        }
+    }
+    for (size_t i = 0;i < all.size();i++) if (needed[i]) order.push_back(all[i]);
+    return order;
+}
+
+// ======================= Main =======================
+void usage() {
+    cerr << "Usage: tbgen <directory> [tables...|all] [--force]\n"
+        << "  Builds distance-to-mate tables for up to " << TB_MAX_PIECES << " pieces (KQK, KRK, KPK, KBNK, KQKR, ...)\n"
+        << "  with every table they depend on. Existing files are kept unless --force is given.\n"
+        << "  Supported: ";
+    for (const string& name : Tablebases::tbAllTables()) cerr << name << " ";
+    cerr << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    initAttacks();
+    initZobrist();
+    if (argc < 3) { usage(); return 2; }
+    string dir = argv[1];
+    vector<string> wanted;
+    bool force = false;
+    for (int i = 2;i < argc;i++) {
+        string arg = argv[i];
+        TbMaterial material;
+        if (arg == "--force") force = true;
+        else if (arg == "all") wanted = Tablebases::tbAllTables();
+        else if (parseMaterial(arg, material)) wanted.push_back(arg);
+        else { cerr << arg << ": not a supported table\n"; usage(); return 2; }
+    }
+
+    for (const string& name : buildOrder(wanted)) {
+        string path = dir + "/" + name + ".ctb";
+        if (!force) {
+            FILE* f = fopen(path.c_str(), "rb");
+            if (f) { fclose(f); cout << name << ": exists\n"; continue; }
+        }
+        auto start = chrono::steady_clock::now();
+        TbMaterial material;
+        parseMaterial(name, material);
+        Tablebases subtables;
+        subtables.init(dir);
+        TableGenerator gen(material, subtables);
+        if (!gen.generate()) { cerr << name << ": generation failed\n"; return 1; }
+        uint64_t bytes, wins, draws, losses;
+        int longest;
+        if (!gen.write(path, bytes, longest)) { cerr << "Error writing " << path << "\n"; return 1; }
+        gen.counts(wins, draws, losses);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << name << ": " << tbEntries(material) << " entries, " << wins << " wins, " << draws << " draws, "
+            << losses << " losses, longest mate " << longest << " plies, " << bytes << " bytes, " << secs << " s\n";
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "bitboard.h"
+
+// ======================= Transposition Table =======================
+// Fixed-size hash table of search results keyed by the Zobrist key. Each
+// entry is two 64-bit words written without locks: the first holds
+// key ^ data, so a reader that sees a torn write from another thread gets
+// a key mismatch and treats it as a miss (the "XOR trick").
+enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct TTData {
+    Move move;
+    int16_t score;
+    int8_t depth;
+    Bound bound;
+};
+
+struct TTEntry {
+    std::atomic<uint64_t> check;   // key ^ data
+    std::atomic<uint64_t> data;    // move | score << 16 | depth << 32 | bound << 40 | generation << 42
+};
+
+// Four entries fill one 64-byte cache line, so a probe touches one line.
+struct alignas(64) TTCluster {
+    TTEntry entry[4];
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable() : clusters(nullptr), clusterMask(0), allocated(0), huge(false), generation(0) {}
+    ~TranspositionTable() { release(); }
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Size is rounded down to a power of two clusters. hugePages asks the
+    // OS for 2 MB pages (transparent huge pages on Linux; ignored elsewhere).
+    void resize(size_t megabytes, bool hugePages = false) {
+        release();
+        size_t count = 1;
+        while ((count * 2) * sizeof(TTCluster) <= megabytes * 1024 * 1024) count *= 2;
+        allocated = count * sizeof(TTCluster);
+#if defined(_WIN32)
+        (void)hugePages;
+        clusters = (TTCluster*)_aligned_malloc(allocated, 64);
+#else
+        const size_t pageSize = 2 * 1024 * 1024;
+        huge = hugePages && allocated >= pageSize;
+        clusters = (TTCluster*)aligned_alloc(huge ? pageSize : 64, allocated);
+#if defined(MADV_HUGEPAGE)
+        if (clusters && huge) madvise(clusters, allocated, MADV_HUGEPAGE);
+#endif
+#endif
+        if (!clusters) { allocated = 0; clusterMask = 0; return; }
+        clusterMask = count - 1;
+        clear();
+    }
+
+    void clear() {
+        for (size_t i = 0;i <= clusterMask && clusters;i++) {
+            for (TTEntry& e : clusters[i].entry) {
+                e.check.store(0, std::memory_order_relaxed);
+                e.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+    }
+
+    // Called once per search so older entries can be told apart and replaced first.
+    void newSearch() { generation = (generation + 1) & 63; }
+
+    size_t sizeBytes() const { return allocated; }
+    bool usesHugePages() const { return huge; }
+
+    bool probe(uint64_t key, TTData& out) const {
+        if (!clusters) return false;
+        const TTCluster& c = clusters[key & clusterMask];
+        for (const TTEntry& e : c.entry) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if ((e.check.load(std::memory_order_relaxed) ^ data) == key && data != 0) {
+                out = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Replacement: same position first, otherwise the entry whose depth,
+    // penalised by age, is lowest.
+    void store(uint64_t key, Move move, int score, int depth, Bound bound) {
+        if (!clusters) return;
+        TTCluster& c = clusters[key & clusterMask];
+        TTEntry* victim = &c.entry[0];
+        int victimWorth = 1 << 30;
+        for (TTEntry& e : c.entry) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if ((e.check.load(std::memory_order_relaxed) ^ data) == key) {
+                // Keep the old best move if this search did not find one
+                if (move == MOVE_NONE) move = Move(data & 0xFFFF);
+                victim = &e;
+                break;
+            }
+            int age = (generation - int((data >> 42) & 63)) & 63;
+            int worth = int((data >> 32) & 0xFF) - 8 * age;
+            if (worth < victimWorth) { victimWorth = worth; victim = &e; }
+        }
+        uint64_t data = uint64_t(move)
+            | (uint64_t(uint16_t(int16_t(score))) << 16)
+            | (uint64_t(uint8_t(depth)) << 32)
+            | (uint64_t(bound) << 40)
+            | (uint64_t(generation) << 42);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    // Permille of sampled entries written during the current search.
+    int hashfull() const {
+        if (!clusters) return 0;
+        size_t samples = clusterMask + 1 < 250 ? clusterMask + 1 : 250;
+        int used = 0;
+        for (size_t i = 0;i < samples;i++) {
+            for (const TTEntry& e : clusters[i].entry) {
+                uint64_t data = e.data.load(std::memory_order_relaxed);
+                if (data != 0 && int((data >> 42) & 63) == generation) used++;
+            }
+        }
+        return int(used * 1000 / (samples * 4));
+    }
+
+private:
+    TTCluster* clusters;
+    size_t clusterMask;
+    size_t allocated;
+    bool huge;
+    int generation;
+
+    static TTData unpack(uint64_t data) {
+        TTData d;
+        d.move = Move(data & 0xFFFF);
+        d.score = int16_t(uint16_t(data >> 16));
+        d.depth = int8_t(uint8_t(data >> 32));
+        d.bound = Bound((data >> 40) & 3);
+        return d;
+    }
+
+    void release() {
+#if defined(_WIN32)
+        _aligned_free(clusters);
+#else
+        free(clusters);
+#endif
+        clusters = nullptr;
+    }
+};
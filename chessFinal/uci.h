@@ -0,0 +1,183 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "smp.h"
+
+// ======================= UCI Front End =======================
+// Speaks the Universal Chess Interface on stdin/stdout so GUIs and match
+// tools can drive the engine. The search runs on its own thread, leaving
+// the input loop free to answer isready and act on stop while it thinks;
+// stop is seen at the searcher's next clock poll (every 2048 nodes).
+// Each output line goes out as a single write, with no screen handling.
+class UciEngine {
+public:
+    UciEngine() : hashMb(16), infinite(false), stopRequested(false) {
+        tt.resize(hashMb);
+        search.setTable(&tt);
+        pos.setStartPosition();
+        keys.assign(1, pos.key);
+    }
+
+    ~UciEngine() { stopSearch(); }
+
+    void setHashSize(size_t megabytes) { hashMb = megabytes; tt.resize(megabytes); }
+    void setThreads(int threads) { search.setThreads(threads); }
+
+    // Reads commands until "quit" or end of input.
+    void loop(std::istream& in) {
+        std::string line;
+        while (std::getline(in, line) && command(line)) {}
+        stopSearch();
+    }
+
+    // One command line; false on "quit".
+    bool command(std::string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::istringstream cmd(line);
+        std::string token;
+        if (!(cmd >> token)) return true;
+        if (token == "quit") return false;
+        else if (token == "uci") {
+            send("id name chessFinal");
+            send("id author chessFinal authors");
+            send("option name Hash type spin default 16 min 1 max 65536");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("uciok");
+        }
+        else if (token == "isready") send("readyok");
+        else if (token == "ucinewgame") { stopSearch(); tt.clear(); }
+        else if (token == "setoption") setOption(cmd);
+        else if (token == "position") setPosition(cmd);
+        else if (token == "go") go(cmd);
+        else if (token == "stop") stopSearch();
+        else if (token == "d") send(pos.fen());
+        return true;
+    }
+
+private:
+    TranspositionTable tt;
+    SmpSearch search;
+    size_t hashMb;
+    Position pos;
+    std::vector<uint64_t> keys;     // every position since the "position" root
+    std::thread searchThread;
+    std::mutex outputLock;
+    std::mutex stateLock;
+    std::condition_variable stopped;
+    bool infinite;                  // "go infinite": hold bestmove until stop
+    bool stopRequested;
+
+    void send(const std::string& s) {
+        std::lock_guard<std::mutex> guard(outputLock);
+        std::string line = s + "\n";
+        fwrite(line.data(), 1, line.size(), stdout);
+        fflush(stdout);
+    }
+
+    // Ends any running search; its bestmove is printed before this returns.
+    void stopSearch() {
+        {
+            std::lock_guard<std::mutex> guard(stateLock);
+            stopRequested = true;
+        }
+        stopped.notify_all();
+        search.stop();
+        if (searchThread.joinable()) searchThread.join();
+    }
+
+    // setoption name <id> value <x>
+    void setOption(std::istringstream& cmd) {
+        std::string token, name, value;
+        cmd >> token;
+        while (cmd >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+        cmd >> value;
+        stopSearch();
+        if (name == "Hash") {
+            int mb = atoi(value.c_str());
+            setHashSize(mb > 0 ? (size_t)mb : 1);
+        }
+        else if (name == "Threads") setThreads(atoi(value.c_str()));
+    }
+
+    // position startpos | fen <FEN> [moves m1 m2 ...]
+    void setPosition(std::istringstream& cmd) {
+        stopSearch();
+        std::string token, fen;
+        cmd >> token;
+        Position p;
+        if (token == "startpos") {
+            p.setStartPosition();
+            cmd >> token;
+        }
+        else if (token == "fen") {
+            while (cmd >> token && token != "moves") fen += token + " ";
+            if (!p.setFen(fen)) { send("info string invalid fen"); return; }
+        }
+        else return;
+
+        pos = p;
+        keys.assign(1, pos.key);
+        while (token == "moves" && cmd >> token) {
+            Move m = moveFromUci(pos, token);
+            if (m == MOVE_NONE) { send("info string illegal move " + token); break; }
+            pos.applyMove(m);
+            keys.push_back(pos.key);
+            token = "moves";
+        }
+    }
+
+    // go [depth D] [movetime ms] [nodes N] [wtime ms] [btime ms] [winc ms]
+    //    [binc ms] [movestogo N] [infinite]
+    void go(std::istringstream& cmd) {
+        stopSearch();
+        SearchLimits limits;
+        int64_t time[2] = { 0, 0 }, inc[2] = { 0, 0 };
+        int movesToGo = 0;
+        bool isInfinite = false;
+        std::string token;
+        while (cmd >> token) {
+            if (token == "depth") cmd >> limits.depth;
+            else if (token == "movetime") cmd >> limits.movetimeMs;
+            else if (token == "nodes") cmd >> limits.nodes;
+            else if (token == "wtime") cmd >> time[WHITE];
+            else if (token == "btime") cmd >> time[BLACK];
+            else if (token == "winc") cmd >> inc[WHITE];
+            else if (token == "binc") cmd >> inc[BLACK];
+            else if (token == "movestogo") cmd >> movesToGo;
+            else if (token == "infinite") isInfinite = true;
+        }
+        if (limits.depth < 1 || limits.depth >= MAX_PLY) limits.depth = MAX_PLY - 1;
+        Color us = pos.sideToMove;
+        if (!isInfinite && limits.movetimeMs == 0 && time[us] > 0)
+            limits.movetimeMs = allocateTime(time[us], inc[us], movesToGo);
+
+        stopRequested = false;
+        infinite = isInfinite;
+        search.onIteration = [this](const SearchInfo& info) {
+            std::string s = "info depth " + std::to_string(info.depth) + " score " + scoreToString(info.score)
+                + " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(info.nps())
+                + " time " + std::to_string(info.elapsedMs) + " hashfull " + std::to_string(info.hashfull) + " pv";
+            for (Move m : info.pv) s += " " + moveToUci(m);
+            send(s);
+            // A stop that arrived before the search cleared its flags
+            std::lock_guard<std::mutex> guard(stateLock);
+            if (stopRequested) search.stop();
+        };
+        Position root = pos;
+        std::vector<uint64_t> rootKeys = keys;
+        searchThread = std::thread([this, root, rootKeys, limits]() {
+            SearchInfo result = search.think(root, rootKeys, limits);
+            // Under "go infinite" the GUI expects bestmove only after stop
+            std::unique_lock<std::mutex> lock(stateLock);
+            stopped.wait(lock, [this]() { return !infinite || stopRequested; });
+            lock.unlock();
+            send("bestmove " + (result.bestMove() == MOVE_NONE ? std::string("0000") : moveToUci(result.bestMove())));
+        });
+    }
+};